@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    DattorroTopology.h
+
+    Delay and tap times of Dattorro's plate reverberator as compile-time
+    tables, converted to samples without any string lookups.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <array>
+
+namespace Reference
+{
+
+namespace DattorroTopology
+{
+    // every delay line of the network, in the order they are listed in the paper
+    enum DelayId
+    {
+        predelay,
+
+        delayLeft1,
+        delayLeft2,
+        delayRight1,
+        delayRight2,
+
+        inputDiffusion1A,
+        inputDiffusion1B,
+        inputDiffusion2A,
+        inputDiffusion2B,
+
+        decayDiffusion1L,
+        decayDiffusion2L,
+        decayDiffusion1R,
+        decayDiffusion2R,
+
+        numDelays
+    };
+
+    // max delay times in milliseconds, indexed by DelayId
+    constexpr float delayTimesMilliseconds[numDelays] =
+    {
+        1000,
+
+        149.62534,
+        124.99579,
+        141.69550,
+        106.28003,
+
+        4.77134,
+        3.59530,
+        12.7348,
+        9.30748,
+
+        22.57988,
+        60.48183,
+        30.50972,
+        89.24431
+    };
+
+    /*  The order the engine walks the network in: the input diffusers
+        stage by stage, then the tank in the order the per-sample loop
+        visits it. The predelay is by far the largest line and is only
+        streamed block-wise, so it goes last.
+    */
+    constexpr DelayId processingOrder[numDelays] =
+    {
+        inputDiffusion1A,
+        inputDiffusion1B,
+        inputDiffusion2A,
+        inputDiffusion2B,
+
+        decayDiffusion1L,
+        delayLeft1,
+        decayDiffusion2L,
+        delayLeft2,
+
+        decayDiffusion1R,
+        delayRight1,
+        decayDiffusion2R,
+        delayRight2,
+
+        predelay
+    };
+
+    // the decay diffusers at the head of each tank half are modulated. the
+    // paper's excursion is 16 samples at 29761 Hz
+    constexpr bool isModulated (DelayId delayLine)
+    {
+        return delayLine == decayDiffusion1L || delayLine == decayDiffusion1R;
+    }
+
+    constexpr float maximumExcursionMilliseconds = 16.0f * 1000.0f / 29761.0f;
+
+    // the decay coefficient is applied twice in each tank half, so four times per trip around the figure eight
+    constexpr int decayGainsPerTankLoop = 4;
+
+    constexpr bool isTankDelay (DelayId delayLine)
+    {
+        return delayLine == delayLeft1 || delayLine == delayLeft2 || delayLine == delayRight1 || delayLine == delayRight2;
+    }
+
+    // every line that recirculates, as opposed to the feed-forward input chain
+    constexpr bool isInTank (DelayId delayLine)
+    {
+        return isTankDelay (delayLine) || delayLine >= decayDiffusion1L;
+    }
+
+    /*  Longest group delay of an allpass diffuser, reached at DC or Nyquist
+        depending on the sign of its coefficient. Energy near those frequencies
+        lingers in the diffuser for this long instead of its plain length.
+    */
+    constexpr float maximumGroupDelayMilliseconds (DelayId diffuser, float coefficient)
+    {
+        auto magnitude = coefficient < 0.0f ? -coefficient : coefficient;
+        return delayTimesMilliseconds[diffuser] * (1.0f + magnitude) / (1.0f - magnitude);
+    }
+
+    struct OutputTap
+    {
+        DelayId delayLine;
+        float milliseconds;
+        float gain;
+    };
+
+    constexpr int numTapsPerChannel = 7;
+
+    // output taps in milliseconds, summed in this order
+    constexpr OutputTap leftOutputTaps[numTapsPerChannel] =
+    {
+        { delayRight1,       8.93787,  0.6f },
+        { delayRight1,      99.92943,  0.6f },
+        { decayDiffusion2R, 64.27875, -0.6f },
+        { delayRight2,      67.06763,  0.6f },
+        { delayLeft1,       66.86603, -0.6f },
+        { decayDiffusion2L,  6.28339, -0.6f },
+        { delayLeft2,       35.81868, -0.6f }
+    };
+
+    constexpr OutputTap rightOutputTaps[numTapsPerChannel] =
+    {
+        { delayLeft1,       11.86116,  0.6f },
+        { delayLeft1,      121.87090,  0.6f },
+        { decayDiffusion2L, 41.26205, -0.6f },
+        { delayLeft2,       89.81553,  0.6f },
+        { delayRight1,      70.93175, -0.6f },
+        { decayDiffusion2R, 11.25634, -0.6f },
+        { delayRight2,       4.06572, -0.6f }
+    };
+
+    constexpr bool hasOutputTaps (DelayId delayLine)
+    {
+        for (int i = 0; i < numTapsPerChannel; ++i)
+            if (leftOutputTaps[i].delayLine == delayLine || rightOutputTaps[i].delayLine == delayLine)
+                return true;
+
+        return false;
+    }
+
+    constexpr int toSamples (float milliseconds, double sampleRate)
+    {
+        return int (milliseconds * (sampleRate / 1000));
+    }
+
+    // all delay and tap lengths of the network at one sample rate
+    struct DelayNetwork
+    {
+        std::array<int, numDelays> delaySamples{};
+        std::array<int, numTapsPerChannel> leftTapSamples{};
+        std::array<int, numTapsPerChannel> rightTapSamples{};
+    };
+
+    constexpr DelayNetwork makeDelayNetwork (double sampleRate)
+    {
+        DelayNetwork network;
+
+        for (int i = 0; i < numDelays; ++i)
+            network.delaySamples[i] = toSamples (delayTimesMilliseconds[i], sampleRate);
+
+        for (int i = 0; i < numTapsPerChannel; ++i)
+        {
+            network.leftTapSamples[i] = toSamples (leftOutputTaps[i].milliseconds, sampleRate);
+            network.rightTapSamples[i] = toSamples (rightOutputTaps[i].milliseconds, sampleRate);
+        }
+
+        return network;
+    }
+
+    // the network at a fixed rate, every length is a compile-time constant
+    template <int sampleRate>
+    struct FixedRateDelayNetwork
+    {
+        static constexpr DelayNetwork network = makeDelayNetwork (sampleRate);
+    };
+
+    static_assert (FixedRateDelayNetwork<44100>::network.delaySamples[inputDiffusion1B] == 158,
+                   "shortest input diffuser should be 158 samples at 44.1 kHz");
+
+    // uses the precomputed tables for the common rates and falls back to converting at runtime
+    inline DelayNetwork getDelayNetwork (double sampleRate)
+    {
+        if (sampleRate == 44100.0) return FixedRateDelayNetwork<44100>::network;
+        if (sampleRate == 48000.0) return FixedRateDelayNetwork<48000>::network;
+        if (sampleRate == 88200.0) return FixedRateDelayNetwork<88200>::network;
+        if (sampleRate == 96000.0) return FixedRateDelayNetwork<96000>::network;
+
+        return makeDelayNetwork (sampleRate);
+    }
+}
+
+} // namespace Reference
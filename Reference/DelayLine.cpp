@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    DelayLine.cpp
+    Created: 17 May 2024 11:15:30am
+    Author:  Till
+
+  ==============================================================================
+*/
+
+// "C:\Program Files\REAPER (x64)reaper.exe"
+
+#include "DelayLine.h"
+
+namespace Reference
+{
+
+template <typename SampleType, typename Interpolation, typename StorageType>
+void DelayLine<SampleType, Interpolation, StorageType>::prepareToPlay (int delayInSamples, int extraCapacity)
+{
+    ownedBuffer.allocate (getRequiredCapacity (delayInSamples, extraCapacity), true);
+    prepareToPlay (delayInSamples, extraCapacity, ownedBuffer.get());
+}
+
+template <typename SampleType, typename Interpolation, typename StorageType>
+void DelayLine<SampleType, Interpolation, StorageType>::prepareToPlay (int delayInSamples, int extraCapacity, StorageType* storage)
+{
+    jassert (delayInSamples > 0 && extraCapacity >= 0 && storage != nullptr);
+
+    // lines running on external storage let go of any buffer of their own
+    if (storage != ownedBuffer.get())
+        ownedBuffer.free();
+
+    length = jmax (1, delayInSamples);
+    mask = getRequiredCapacity (length, extraCapacity) - 1;
+    writeIndex = 0;
+    buffer = storage;
+
+    clear();
+}
+
+template <typename SampleType, typename Interpolation, typename StorageType>
+void DelayLine<SampleType, Interpolation, StorageType>::clear() noexcept
+{
+    if (buffer != nullptr)
+    {
+        if constexpr (isNativeStorage)
+            FloatVectorOperations::clear (buffer, mask + 1);
+        else
+            std::fill (buffer, buffer + mask + 1, StorageType());
+    }
+
+    interpolation.reset();
+}
+
+template <typename SampleType, typename Interpolation, typename StorageType>
+void DelayLine<SampleType, Interpolation, StorageType>::releaseResources()
+{
+    ownedBuffer.free();
+    buffer = nullptr;
+
+    length = 0;
+    mask = 0;
+    writeIndex = 0;
+    interpolation.reset();
+}
+
+template class DelayLine<float, DelayInterpolation::None>;
+template class DelayLine<float, DelayInterpolation::Linear>;
+template class DelayLine<float, DelayInterpolation::Cubic>;
+template class DelayLine<float, DelayInterpolation::Allpass>;
+
+template class DelayLine<double, DelayInterpolation::None>;
+template class DelayLine<double, DelayInterpolation::Linear>;
+template class DelayLine<double, DelayInterpolation::Cubic>;
+template class DelayLine<double, DelayInterpolation::Allpass>;
+
+// reduced-precision storage for the predelay and long unmodulated lines
+template class DelayLine<float, DelayInterpolation::None, HalfFloat>;
+template class DelayLine<float, DelayInterpolation::Linear, HalfFloat>;
+template class DelayLine<double, DelayInterpolation::None, HalfFloat>;
+
+} // namespace Reference
@@ -0,0 +1,320 @@
+/*
+  ==============================================================================
+
+    DelayLine.h
+    Created: 17 May 2024 11:15:30am
+    Author:  Till
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "HalfFloat.h"
+
+namespace Reference
+{
+
+/*
+    Interpolation policies for fractional reads. Each one reads around
+    position, the buffer index of the sample at the integer part of the
+    delay, where (position - 1) & mask is one sample older. The buffer may
+    hold a narrower storage type, which is converted as it is read.
+*/
+namespace DelayInterpolation
+{
+    // integer reads only, the fraction is dropped
+    struct None
+    {
+        static constexpr int minimumDelay = 1;
+        static constexpr int extraSamples = 0;
+
+        template <typename SampleType, typename StorageType>
+        SampleType read (const StorageType* buffer, int mask, int position, SampleType fraction) noexcept
+        {
+            ignoreUnused (mask, fraction);
+            return SampleType (buffer[position]);
+        }
+
+        void reset() noexcept {}
+    };
+
+    struct Linear
+    {
+        static constexpr int minimumDelay = 1;
+        static constexpr int extraSamples = 1;
+
+        template <typename SampleType, typename StorageType>
+        SampleType read (const StorageType* buffer, int mask, int position, SampleType fraction) noexcept
+        {
+            auto value1 = SampleType (buffer[position]);
+            auto value2 = SampleType (buffer[(position - 1) & mask]);
+
+            return value1 + fraction * (value2 - value1);
+        }
+
+        void reset() noexcept {}
+    };
+
+    // third order Lagrange over the samples at delay - 1 .. delay + 2
+    struct Cubic
+    {
+        static constexpr int minimumDelay = 2;
+        static constexpr int extraSamples = 2;
+
+        template <typename SampleType, typename StorageType>
+        SampleType read (const StorageType* buffer, int mask, int position, SampleType fraction) noexcept
+        {
+            auto value1 = SampleType (buffer[(position + 1) & mask]);
+            auto value2 = SampleType (buffer[position]);
+            auto value3 = SampleType (buffer[(position - 1) & mask]);
+            auto value4 = SampleType (buffer[(position - 2) & mask]);
+
+            auto delayFrac = fraction + SampleType (1.0);
+            auto d1 = delayFrac - SampleType (1.0);
+            auto d2 = delayFrac - SampleType (2.0);
+            auto d3 = delayFrac - SampleType (3.0);
+
+            auto c1 = -d1 * d2 * d3 / SampleType (6.0);
+            auto c2 = d2 * d3 * SampleType (0.5);
+            auto c3 = -d1 * d3 * SampleType (0.5);
+            auto c4 = d1 * d2 / SampleType (6.0);
+
+            return value1 * c1 + delayFrac * (value2 * c2 + value3 * c3 + value4 * c4);
+        }
+
+        void reset() noexcept {}
+    };
+
+    // first order Thiran allpass, flat magnitude but keeps one sample of state
+    struct Allpass
+    {
+        static constexpr int minimumDelay = 1;
+        static constexpr int extraSamples = 1;
+
+        template <typename SampleType, typename StorageType>
+        SampleType read (const StorageType* buffer, int mask, int position, SampleType fraction) noexcept
+        {
+            auto value1 = SampleType (buffer[position]);
+            auto value2 = SampleType (buffer[(position - 1) & mask]);
+
+            auto alpha = (SampleType (1.0) - fraction) / (SampleType (1.0) + fraction);
+            auto output = value2 + alpha * (value1 - SampleType (lastOutput));
+            lastOutput = output;
+
+            return output;
+        }
+
+        void reset() noexcept { lastOutput = 0.0; }
+
+        // wide enough for either sample type
+        double lastOutput = 0.0;
+    };
+}
+
+/*
+    Circular buffer whose capacity is rounded up to a power of two, so the
+    read and write positions wrap with a mask instead of a compare.
+
+    Reads are only checked in debug builds. Callers validate their tap
+    lengths once when preparing, which keeps the per-sample path free of
+    data-dependent branches.
+
+    The interpolation policy only affects fractional reads, lines that are
+    never modulated use the default and pay nothing for it.
+
+    StorageType is what the buffer holds, e.g. HalfFloat to halve the
+    memory of a long line. Samples are converted on every push and read,
+    native storage skips all of that.
+*/
+template <typename SampleType = float, typename Interpolation = DelayInterpolation::None, typename StorageType = SampleType>
+class DelayLine
+{
+public:
+    using Sample = SampleType;
+    using Storage = StorageType;
+
+    DelayLine() = default;
+
+    // number of samples of storage a line of this length needs
+    static int getRequiredCapacity (int delayInSamples, int extraCapacity = 0)
+    {
+        return nextPowerOfTwo (jmax (1, delayInSamples) + jmax (0, extraCapacity));
+    }
+
+    // extraCapacity keeps that many more samples around for reading whole blocks back
+    void prepareToPlay (int delayInSamples, int extraCapacity = 0);
+
+    /*  Same, but runs on getRequiredCapacity() samples owned by the caller,
+        e.g. one arena shared by a whole network. The storage is cleared here
+        and has to stay valid until the line is prepared again.
+    */
+    void prepareToPlay (int delayInSamples, int extraCapacity, StorageType* storage);
+
+    // zeroes the history without reallocating
+    void clear() noexcept;
+
+    // frees the buffer, or lets go of the caller's storage. prepareToPlay has to run again before use
+    void releaseResources();
+
+    void pushSample (SampleType sample) noexcept
+    {
+        buffer[writeIndex] = StorageType (sample);
+        writeIndex = (writeIndex + 1) & mask;
+    }
+
+    // returns the sample pushed delayInSamples pushes ago (1 = the latest one)
+    SampleType getSample (int delayInSamples) const noexcept
+    {
+        jassert (delayInSamples > 0 && delayInSamples <= mask + 1);
+        return SampleType (buffer[(writeIndex - delayInSamples) & mask]);
+    }
+
+    // returns the sample leaving a delay of the prepared length
+    SampleType getOutput() const noexcept
+    {
+        return getSample (length);
+    }
+
+    // returns the sample delayInSamples behind, interpolated by the policy
+    SampleType getSample (SampleType delayInSamples) noexcept
+    {
+        auto delayInt = (int) delayInSamples;
+        auto fraction = delayInSamples - (SampleType) delayInt;
+
+        jassert (delayInt >= Interpolation::minimumDelay && delayInt + Interpolation::extraSamples <= mask + 1);
+        return interpolation.read (buffer, mask, (writeIndex - delayInt) & mask, fraction);
+    }
+
+    int getLength() const noexcept { return length; }
+
+    void pushBlock (const SampleType* samples, int numSamples) noexcept
+    {
+        while (numSamples > 0)
+        {
+            auto run = jmin (numSamples, mask + 1 - writeIndex);
+
+            if constexpr (isNativeStorage)
+            {
+                FloatVectorOperations::copy (buffer + writeIndex, samples, run);
+            }
+            else
+            {
+                for (int i = 0; i < run; ++i)
+                    buffer[writeIndex + i] = StorageType (samples[i]);
+            }
+
+            writeIndex = (writeIndex + run) & mask;
+            samples += run;
+            numSamples -= run;
+        }
+    }
+
+    // copies what getSample (delayInSamples) returned after each of the last numSamples pushes to destination
+    void readBlock (SampleType* destination, int numSamples, int delayInSamples) const noexcept
+    {
+        jassert (delayInSamples > 0 && numSamples + delayInSamples - 1 <= mask + 1);
+
+        auto readIndex = (writeIndex - numSamples - delayInSamples + 1) & mask;
+
+        while (numSamples > 0)
+        {
+            auto run = jmin (numSamples, mask + 1 - readIndex);
+
+            if constexpr (isNativeStorage)
+            {
+                FloatVectorOperations::copy (destination, buffer + readIndex, run);
+            }
+            else
+            {
+                for (int i = 0; i < run; ++i)
+                    destination[i] = SampleType (buffer[readIndex + i]);
+            }
+
+            readIndex = (readIndex + run) & mask;
+            destination += run;
+            numSamples -= run;
+        }
+    }
+
+    /*  Adds gain times what getSample (delayInSamples) returned after each
+        of the last numSamples pushes to destination. That history is one
+        contiguous (possibly wrapped) segment of the buffer, so this is a
+        vectorised multiply-add instead of numSamples scattered reads.
+        The destination may have a different sample type, in which case
+        the history is converted on the way.
+    */
+    template <typename DestinationType>
+    void addBlockWithMultiply (DestinationType* destination, int numSamples, int delayInSamples, DestinationType gain) const noexcept
+    {
+        jassert (delayInSamples > 0 && numSamples + delayInSamples - 1 <= mask + 1);
+
+        auto readIndex = (writeIndex - numSamples - delayInSamples + 1) & mask;
+
+        while (numSamples > 0)
+        {
+            auto run = jmin (numSamples, mask + 1 - readIndex);
+
+            if constexpr (std::is_same_v<DestinationType, StorageType>)
+            {
+                FloatVectorOperations::addWithMultiply (destination, buffer + readIndex, gain, run);
+            }
+            else
+            {
+                for (int i = 0; i < run; ++i)
+                    destination[i] += DestinationType (buffer[readIndex + i]) * gain;
+            }
+
+            readIndex = (readIndex + run) & mask;
+            destination += run;
+            numSamples -= run;
+        }
+    }
+
+    /*  Runs a whole block through the line in place. For every sample,
+        process (input, delayOutput, delayInput) gets the sample leaving a
+        delay of delayInSamples, sets what to push and returns the output.
+
+        The block is split into runs in which neither position wraps, so
+        when the delay is at least as long as a run the loop has no
+        dependencies between iterations and can be vectorised.
+    */
+    template <typename Processor>
+    void processBlock (SampleType* samples, int numSamples, int delayInSamples, Processor&& process) noexcept
+    {
+        jassert (delayInSamples > 0 && delayInSamples <= mask + 1);
+
+        while (numSamples > 0)
+        {
+            auto readIndex = (writeIndex - delayInSamples) & mask;
+            auto run = jmin (numSamples, mask + 1 - readIndex, mask + 1 - writeIndex);
+
+            const StorageType* reader = buffer + readIndex;
+            StorageType* writer = buffer + writeIndex;
+
+            for (int i = 0; i < run; ++i)
+            {
+                SampleType delayInput;
+                samples[i] = process (samples[i], SampleType (reader[i]), delayInput);
+                writer[i] = StorageType (delayInput);
+            }
+
+            writeIndex = (writeIndex + run) & mask;
+            samples += run;
+            numSamples -= run;
+        }
+    }
+
+private:
+    static constexpr bool isNativeStorage = std::is_same_v<StorageType, SampleType>;
+
+    HeapBlock<StorageType> ownedBuffer;
+    StorageType* buffer{ nullptr };
+    Interpolation interpolation;
+    int length{ 0 };
+    int mask{ 0 };
+    int writeIndex{ 0 };
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DelayLine)
+};
+
+} // namespace Reference
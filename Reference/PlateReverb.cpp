@@ -0,0 +1,842 @@
+/*
+  ==============================================================================
+
+    PlateReverb.cpp
+    Created: 17 May 2024 12:00:32pm
+    Author:  Till
+
+  ==============================================================================
+*/
+
+#include "PlateReverb.h"
+
+namespace Reference
+{
+
+using DelayId = DattorroTopology::DelayId;
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+PlateReverb<SampleType, TankType, halfPrecisionDelays>::PlateReverb()
+{
+    // set base parameters
+    decay = 0.5;
+    decayDiffusion1 = 0.7;
+    decayDiffusion2 = 0.5;
+    inputDiffusion1 = 0.75;
+    inputDiffusion2 = 0.625;
+    bandwidth = 0.9995;
+    damping = 0.0005;
+    mix = 0.5;
+    modulationRate = 1.0;
+    modulationDepth = 0.0;
+    setSilenceThreshold (defaultSilenceThresholdDecibels);
+
+    decaySmoother.setCurrentAndTargetValue (decay);
+    decayDiffusion1Smoother.setCurrentAndTargetValue (decayDiffusion1);
+    inputDiffusion1Smoother.setCurrentAndTargetValue (inputDiffusion1);
+    inputDiffusion2Smoother.setCurrentAndTargetValue (inputDiffusion2);
+    bandwidthSmoother.setCurrentAndTargetValue (bandwidth);
+    dampingSmoother.setCurrentAndTargetValue (damping);
+    mixSmoother.setCurrentAndTargetValue (mix);
+    modulationDepthSmoother.setCurrentAndTargetValue (modulationDepth);
+    predelaySmoother.setCurrentAndTargetValue (0.0f);
+
+    // initialise samples values
+    samplesLeftOutputTaps.fill (0);
+    samplesRightOutputTaps.fill (0);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::prepareToPlay(double sampleRate, int newMaximumBlockSize)
+{
+    currentSampleRate = sampleRate;
+
+    // jump straight to the current targets, ramps only make sense while playing
+    decaySmoother.reset (sampleRate, smoothingTimeSeconds);
+    decayDiffusion1Smoother.reset (sampleRate, smoothingTimeSeconds);
+    inputDiffusion1Smoother.reset (sampleRate, smoothingTimeSeconds);
+    inputDiffusion2Smoother.reset (sampleRate, smoothingTimeSeconds);
+    bandwidthSmoother.reset (sampleRate, smoothingTimeSeconds);
+    dampingSmoother.reset (sampleRate, smoothingTimeSeconds);
+    mixSmoother.reset (sampleRate, smoothingTimeSeconds);
+    modulationDepthSmoother.reset (sampleRate, smoothingTimeSeconds);
+    predelaySmoother.reset (sampleRate, predelaySmoothingTimeSeconds);
+    updateCoefficients (0);
+
+    maximumBlockSize = jmax (1, newMaximumBlockSize);
+
+    // storage is sized for whatever was reserved, so preparing within that never allocates
+    auto storageSampleRate = jmax (sampleRate, reservedSampleRate);
+    auto storageBlockSize = jmax (maximumBlockSize, reservedBlockSize);
+
+    // scratch space for the tank input and wet output of one block
+    blockBuffer.setSize (numBlockChannels, storageBlockSize, false, false, true);
+
+    // convert all delay times to samples using new sample rate
+    auto network = DattorroTopology::getDelayNetwork (sampleRate);
+
+    // the modulated lines swing up to the maximum excursion around their length
+    auto excursion = getExcursionSamples (sampleRate);
+    maximumExcursionSamples = float (excursion - 1);
+
+    allocateDelayLines (sampleRate, maximumBlockSize, getArenaSize (storageSampleRate, storageBlockSize));
+
+    jassert (network.delaySamples[DelayId::decayDiffusion1L] - excursion >= ModulationInterpolation::minimumDelay
+             && network.delaySamples[DelayId::decayDiffusion1R] - excursion >= ModulationInterpolation::minimumDelay);
+
+    lfoSine = 0.0f;
+    lfoCosine = 1.0f;
+
+    bandwidthOnepole.clear();
+    dampingOnepoleLeft.clear();
+    dampingOnepoleRight.clear();
+
+    // the longest a signal can take to pass through the input chain and once
+    // around the tank, predelay excluded since its tap can change while playing
+    networkDrainSamples = excursion;
+
+    for (int i = 0; i < DattorroTopology::numDelays; ++i)
+        if (i != DelayId::predelay)
+            networkDrainSamples += network.delaySamples[i];
+
+    // every line has just been zeroed, so there is nothing to process until input arrives
+    samplesBelowThreshold = 0;
+    sleeping = true;
+
+    // validate every tap once here, the per-sample reads are unchecked in release builds
+    for (int i = 0; i < DattorroTopology::numTapsPerChannel; ++i)
+    {
+        samplesLeftOutputTaps[i] = clampTap (network.leftTapSamples[i],
+                                             network.delaySamples[DattorroTopology::leftOutputTaps[i].delayLine]);
+        samplesRightOutputTaps[i] = clampTap (network.rightTapSamples[i],
+                                              network.delaySamples[DattorroTopology::rightOutputTaps[i].delayLine]);
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::reserve (double maximumSampleRate, int newReservedBlockSize)
+{
+    reservedSampleRate = jmax (0.0, maximumSampleRate);
+    reservedBlockSize = jmax (0, newReservedBlockSize);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::releaseResources()
+{
+    for (auto& delayLine : inputDelayLines)
+        delayLine.releaseResources();
+
+    predelayLine.releaseResources();
+
+    for (auto& delayLine : delayLines)
+        delayLine.releaseResources();
+
+    for (auto& delayLine : longDelayLines)
+        delayLine.releaseResources();
+
+    decayDiffusion1L.releaseResources();
+    decayDiffusion1R.releaseResources();
+
+    arena.free();
+    arenaSize = 0;
+
+    blockBuffer.setSize (0, 0);
+    maximumBlockSize = 0;
+
+    samplesBelowThreshold = 0;
+    sleeping = true;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+template <typename Visitor>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::visitDelayLines (double sampleRate, int blockSize, Visitor&& visit)
+{
+    auto network = DattorroTopology::getDelayNetwork (sampleRate);
+    auto excursion = getExcursionSamples (sampleRate);
+
+    for (auto id : DattorroTopology::processingOrder)
+    {
+        auto delayInSamples = network.delaySamples[id];
+
+        // the predelay and lines with output taps keep a block of extra history so
+        // their taps can be read back block-wise, the predelay one more to interpolate
+        if (id == DelayId::predelay)
+            visit (predelayLine, delayInSamples, blockSize + PredelayInterpolation::extraSamples);
+        else if (! DattorroTopology::isInTank (id))
+            visit (inputDelayLines[id], delayInSamples, 0);
+        else if (id == DelayId::decayDiffusion1L)
+            visit (decayDiffusion1L, delayInSamples, excursion + ModulationInterpolation::extraSamples);
+        else if (id == DelayId::decayDiffusion1R)
+            visit (decayDiffusion1R, delayInSamples, excursion + ModulationInterpolation::extraSamples);
+        else if (DattorroTopology::isTankDelay (id))
+            visit (longDelayLines[id], delayInSamples, DattorroTopology::hasOutputTaps (id) ? blockSize : 0);
+        else
+            visit (delayLines[id], delayInSamples, DattorroTopology::hasOutputTaps (id) ? blockSize : 0);
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+size_t PlateReverb<SampleType, TankType, halfPrecisionDelays>::getArenaSize (double sampleRate, int blockSize)
+{
+    size_t size = 0;
+
+    visitDelayLines (sampleRate, blockSize, [&size] (auto& delayLine, int delayInSamples, int extraCapacity)
+    {
+        size += getStorageBytes<std::remove_reference_t<decltype (delayLine)>> (delayInSamples, extraCapacity);
+    });
+
+    return size;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::allocateDelayLines (double sampleRate, int blockSize, size_t storageSize)
+{
+    // only reallocates when the storage needed grew or shrank
+    if (storageSize != arenaSize)
+    {
+        arena.allocate (storageSize + cacheLineSize, false);
+        arenaSize = storageSize;
+    }
+
+    auto address = reinterpret_cast<uintptr_t> (arena.get());
+    auto* base = reinterpret_cast<char*> ((address + cacheLineSize - 1) & ~(uintptr_t) (cacheLineSize - 1));
+    size_t offset = 0;
+
+    visitDelayLines (sampleRate, blockSize, [&] (auto& delayLine, int delayInSamples, int extraCapacity)
+    {
+        using LineType = std::remove_reference_t<decltype (delayLine)>;
+
+        delayLine.prepareToPlay (delayInSamples, extraCapacity, reinterpret_cast<typename LineType::Storage*> (base + offset));
+        offset += getStorageBytes<LineType> (delayInSamples, extraCapacity);
+    });
+
+    // every line grows with the sample rate, so a network sized for a higher one always fits
+    jassert (offset <= arenaSize);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+template <typename DelayLineType>
+size_t PlateReverb<SampleType, TankType, halfPrecisionDelays>::getStorageBytes (int delayInSamples, int extraCapacity)
+{
+    auto bytes = (size_t) DelayLineType::getRequiredCapacity (delayInSamples, extraCapacity) * sizeof (typename DelayLineType::Storage);
+
+    // every line starts on a cache line of its own
+    return (bytes + cacheLineSize - 1) & ~(cacheLineSize - 1);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+int PlateReverb<SampleType, TankType, halfPrecisionDelays>::getExcursionSamples (double sampleRate)
+{
+    // one more than the LFO swing, the modulated reads land between two samples
+    return DattorroTopology::toSamples (DattorroTopology::maximumExcursionMilliseconds, sampleRate) + 1;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+size_t PlateReverb<SampleType, TankType, halfPrecisionDelays>::getFootprintInBytes() const
+{
+    auto blockBytes = (size_t) blockBuffer.getNumChannels() * (size_t) blockBuffer.getNumSamples() * sizeof (SampleType);
+    auto arenaBytes = arenaSize > 0 ? arenaSize + cacheLineSize : 0;
+
+    return sizeof (*this) + arenaBytes + blockBytes;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processBlock(juce::AudioBuffer<SampleType>& buffer, int numSamples, int numChannels)
+{
+    // released, or never prepared
+    jassert (maximumBlockSize > 0);
+
+    if (maximumBlockSize == 0)
+        return;
+
+    SampleType* writeBufferL = buffer.getWritePointer (0);
+    SampleType* writeBufferR = buffer.getWritePointer (1);
+
+    auto* tankInput = blockBuffer.getWritePointer (tankInputChannel);
+    auto* outputLeft = blockBuffer.getWritePointer (outputLeftChannel);
+    auto* outputRight = blockBuffer.getWritePointer (outputRightChannel);
+
+    // host blocks larger than announced in prepareToPlay are split up,
+    // and into control blocks while any parameter is ramping
+    for (int startSample = 0; startSample < numSamples;)
+    {
+        auto blockSize = jmin (maximumBlockSize, numSamples - startSample);
+
+        if (isSmoothing())
+            blockSize = jmin (blockSize, controlRateInterval);
+
+        updateCoefficients (blockSize);
+
+        auto* blockL = writeBufferL + startSample;
+        auto* blockR = writeBufferR + startSample;
+
+        auto inputPeak = jmax (FloatVectorOperations::findMaximum (blockL, blockSize),
+                               -FloatVectorOperations::findMinimum (blockL, blockSize),
+                               FloatVectorOperations::findMaximum (blockR, blockSize),
+                               -FloatVectorOperations::findMinimum (blockR, blockSize));
+
+        if (isSleeping())
+        {
+            // the wet signal is silent, only the dry part remains
+            if (inputPeak < silenceThreshold)
+            {
+                // the predelay line is empty, so its tap can skip ahead
+                predelaySmoother.skip (blockSize);
+
+                FloatVectorOperations::multiply (blockL, SampleType(1.0) - mix, blockSize);
+                FloatVectorOperations::multiply (blockR, SampleType(1.0) - mix, blockSize);
+
+                startSample += blockSize;
+                continue;
+            }
+
+            // the network was cleared when it fell asleep, so it picks up from silence
+            sleeping = false;
+        }
+
+        // the feed-forward input chain runs stage by stage over the whole block
+        processInputChain (blockL, blockR, tankInput, blockSize);
+
+        processTank (tankInput, outputLeft, outputRight, blockSize);
+
+        updateSilenceTracking (inputPeak, outputLeft, outputRight, blockSize);
+
+        // dry/wet mix
+        FloatVectorOperations::multiply (blockL, SampleType(1.0) - mix, blockSize);
+        FloatVectorOperations::addWithMultiply (blockL, outputLeft, mix, blockSize);
+        FloatVectorOperations::multiply (blockR, SampleType(1.0) - mix, blockSize);
+        FloatVectorOperations::addWithMultiply (blockR, outputRight, mix, blockSize);
+
+        startSample += blockSize;
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::updateCoefficients (int numSamples)
+{
+    auto newDecay = decaySmoother.skip (numSamples);
+
+    decay = TankType (newDecay);
+    decayDiffusion2 = TankType (getDecayDiffusion2 (newDecay));
+    decayDiffusion1 = TankType (decayDiffusion1Smoother.skip (numSamples));
+    inputDiffusion1 = SampleType (inputDiffusion1Smoother.skip (numSamples));
+    inputDiffusion2 = SampleType (inputDiffusion2Smoother.skip (numSamples));
+    bandwidth = SampleType (bandwidthSmoother.skip (numSamples));
+    damping = TankType (dampingSmoother.skip (numSamples));
+    mix = SampleType (mixSmoother.skip (numSamples));
+    modulationDepth = modulationDepthSmoother.skip (numSamples);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::updateSilenceTracking (SampleType inputPeak, const SampleType* outputLeft, const SampleType* outputRight, int numSamples)
+{
+    auto outputPeak = jmax (FloatVectorOperations::findMaximum (outputLeft, numSamples),
+                            -FloatVectorOperations::findMinimum (outputLeft, numSamples),
+                            FloatVectorOperations::findMaximum (outputRight, numSamples),
+                            -FloatVectorOperations::findMinimum (outputRight, numSamples));
+
+    if (jmax (inputPeak, outputPeak) >= silenceThreshold)
+    {
+        samplesBelowThreshold = 0;
+        return;
+    }
+
+    samplesBelowThreshold += numSamples;
+
+    // the predelay holds on to the input for as long as its tap, wherever it is gliding
+    auto predelayMilliseconds = jmax (predelaySmoother.getCurrentValue(), predelaySmoother.getTargetValue());
+    auto predelaySamples = (int) std::ceil (predelayMilliseconds * currentSampleRate / 1000.0) + 1;
+
+    // whatever is left in the lines is below the threshold by now. clearing them
+    // makes waking up again exact and keeps denormals out of the sleeping tank
+    if (samplesBelowThreshold >= predelaySamples + networkDrainSamples)
+    {
+        clearDelayLines();
+        sleeping = true;
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::clearDelayLines()
+{
+    for (auto& delayLine : inputDelayLines)
+        delayLine.clear();
+
+    predelayLine.clear();
+
+    for (auto& delayLine : delayLines)
+        delayLine.clear();
+
+    for (auto& delayLine : longDelayLines)
+        delayLine.clear();
+
+    decayDiffusion1L.clear();
+    decayDiffusion1R.clear();
+
+    bandwidthOnepole.clear();
+    dampingOnepoleLeft.clear();
+    dampingOnepoleRight.clear();
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+bool PlateReverb<SampleType, TankType, halfPrecisionDelays>::isSmoothing() const
+{
+    return decaySmoother.isSmoothing()
+        || decayDiffusion1Smoother.isSmoothing()
+        || inputDiffusion1Smoother.isSmoothing()
+        || inputDiffusion2Smoother.isSmoothing()
+        || bandwidthSmoother.isSmoothing()
+        || dampingSmoother.isSmoothing()
+        || mixSmoother.isSmoothing()
+        || modulationDepthSmoother.isSmoothing();
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processPredelay (SampleType* samples, int numSamples)
+{
+    // the block goes in first and the tap reads behind it, so a delay of 1 is no predelay at all
+    predelayLine.pushBlock (samples, numSamples);
+
+    auto samplesPerMillisecond = SampleType (currentSampleRate / 1000.0);
+    auto maximumTap = SampleType (predelayLine.getLength());
+
+    if (! predelaySmoother.isSmoothing())
+    {
+        // a static tap is one contiguous segment of the history, blended with its neighbour for the fraction
+        auto tap = jlimit (SampleType(0.0), maximumTap, SampleType (predelaySmoother.getTargetValue()) * samplesPerMillisecond);
+        auto tapInSamples = (int) tap;
+        auto fraction = tap - SampleType (tapInSamples);
+
+        // no predelay, the block already holds the output and skips a trip through reduced-precision storage
+        if (tap == SampleType(0.0))
+            return;
+
+        predelayLine.readBlock (samples, numSamples, tapInSamples + 1);
+
+        if (fraction > SampleType(0.0))
+        {
+            FloatVectorOperations::multiply (samples, SampleType(1.0) - fraction, numSamples);
+            predelayLine.addBlockWithMultiply (samples, numSamples, tapInSamples + 2, fraction);
+        }
+
+        return;
+    }
+
+    // a moving tap is interpolated sample by sample. sample i of the block
+    // was pushed numSamples - 1 - i samples before the write head
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto tap = jlimit (SampleType(0.0), maximumTap, SampleType (predelaySmoother.getNextValue()) * samplesPerMillisecond);
+        samples[i] = predelayLine.getSample (tap + SampleType (numSamples - i));
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processInputChain (const SampleType* inputLeft, const SampleType* inputRight, SampleType* output, int numSamples)
+{
+    // get input signal and sum left + right channels
+    FloatVectorOperations::add (output, inputLeft, inputRight, numSamples);
+    FloatVectorOperations::multiply (output, SampleType(0.5), numSamples);
+
+    processPredelay (output, numSamples);
+
+    // input signal bandwidth control
+    FloatVectorOperations::multiply (output, bandwidth, numSamples);
+    processOnepoleBlock (output, numSamples, SampleType(1.0) - bandwidth, bandwidthOnepole);
+
+    // input diffusion
+    processLatticeBlock (output, numSamples, inputDiffusion1, inputDelayLines[DelayId::inputDiffusion1A]);
+    processLatticeBlock (output, numSamples, inputDiffusion1, inputDelayLines[DelayId::inputDiffusion1B]);
+    processLatticeBlock (output, numSamples, inputDiffusion2, inputDelayLines[DelayId::inputDiffusion2A]);
+    processLatticeBlock (output, numSamples, inputDiffusion2, inputDelayLines[DelayId::inputDiffusion2B]);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processTank (const SampleType* input, SampleType* outputLeft, SampleType* outputRight, int numSamples)
+{
+    // unmodulated lines skip the fractional reads and the LFO entirely
+    if (modulationDepth > 0.0f)
+        processTankSamples<true> (input, numSamples);
+    else
+        processTankSamples<false> (input, numSamples);
+
+    // output, gathered block-wise now that the whole block has been written into the tank
+    gatherOutputTaps (outputLeft, outputRight, numSamples);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::gatherOutputTaps (SampleType* outputLeft, SampleType* outputRight, int numSamples)
+{
+    FloatVectorOperations::clear (outputLeft, numSamples);
+    FloatVectorOperations::clear (outputRight, numSamples);
+
+    for (int i = 0; i < DattorroTopology::numTapsPerChannel; ++i)
+    {
+        const auto& leftTap = DattorroTopology::leftOutputTaps[i];
+        const auto& rightTap = DattorroTopology::rightOutputTaps[i];
+
+        addOutputTap (outputLeft, numSamples, leftTap.delayLine, samplesLeftOutputTaps[i], SampleType (leftTap.gain));
+        addOutputTap (outputRight, numSamples, rightTap.delayLine, samplesRightOutputTaps[i], SampleType (rightTap.gain));
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::addOutputTap (SampleType* output, int numSamples, DattorroTopology::DelayId id, int tapInSamples, SampleType gain)
+{
+    // the taps are read one sample behind the write head
+    if (DattorroTopology::isTankDelay (id))
+        longDelayLines[id].addBlockWithMultiply (output, numSamples, tapInSamples + 1, gain);
+    else
+        delayLines[id].addBlockWithMultiply (output, numSamples, tapInSamples + 1, gain);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+template <bool modulated>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processTankSamples (const SampleType* input, int numSamples)
+{
+    auto& delayLeft1 = longDelayLines[DelayId::delayLeft1];
+    auto& delayLeft2 = longDelayLines[DelayId::delayLeft2];
+    auto& delayRight1 = longDelayLines[DelayId::delayRight1];
+    auto& delayRight2 = longDelayLines[DelayId::delayRight2];
+
+    auto& decayDiffusion2L = delayLines[DelayId::decayDiffusion2L];
+    auto& decayDiffusion2R = delayLines[DelayId::decayDiffusion2R];
+
+    TankType delayLeft = TankType (decayDiffusion1L.getLength());
+    TankType delayRight = TankType (decayDiffusion1R.getLength());
+    TankType delayLeftIncrement = 0.0;
+    TankType delayRightIncrement = 0.0;
+
+    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++)
+    {
+        if constexpr (modulated)
+        {
+            // step the LFO and ramp both modulated delay times towards where it ends up
+            if (sampleIndex % lfoUpdateInterval == 0)
+            {
+                auto segmentLength = jmin (lfoUpdateInterval, numSamples - sampleIndex);
+                auto excursion = modulationDepth * maximumExcursionSamples;
+                auto sineStart = lfoSine;
+                auto cosineStart = lfoCosine;
+
+                advanceLfo (segmentLength);
+
+                delayLeft = TankType (decayDiffusion1L.getLength()) + TankType (excursion * sineStart);
+                delayRight = TankType (decayDiffusion1R.getLength()) + TankType (excursion * cosineStart);
+                delayLeftIncrement = TankType (excursion * (lfoSine - sineStart) / float (segmentLength));
+                delayRightIncrement = TankType (excursion * (lfoCosine - cosineStart) / float (segmentLength));
+            }
+        }
+
+        // reverb tank
+        TankType reverbTankInput = input[sampleIndex];
+        TankType sample = reverbTankInput;
+
+        // reverb tank left
+        sample = sample + (delayRight2.getOutput() * decay);
+        if constexpr (modulated)
+        {
+            sample = calculateModulatedReverseLattice (sample, decayDiffusion1, delayLeft, decayDiffusion1L);
+            delayLeft += delayLeftIncrement;
+        }
+        else
+        {
+            sample = calculateReverseLattice (sample, decayDiffusion1, decayDiffusion1L);
+        }
+
+        sample = processDelay (sample, delayLeft1);
+
+        sample = sample * (TankType(1.0) - damping);
+        sample = calculateOnepole (sample, damping, dampingOnepoleLeft);
+
+        sample = sample * decay;
+        sample = calculateLattice (sample, decayDiffusion2, decayDiffusion2L);
+
+        sample = processDelay (sample, delayLeft2);
+        sample = sample * decay;
+
+        // reverb tank right
+        sample = sample + reverbTankInput;
+        if constexpr (modulated)
+        {
+            sample = calculateModulatedReverseLattice (sample, decayDiffusion1, delayRight, decayDiffusion1R);
+            delayRight += delayRightIncrement;
+        }
+        else
+        {
+            sample = calculateReverseLattice (sample, decayDiffusion1, decayDiffusion1R);
+        }
+
+        sample = processDelay (sample, delayRight1);
+
+        sample = sample * (TankType(1.0) - damping);
+        sample = calculateOnepole (sample, damping, dampingOnepoleRight);
+
+        sample = sample * decay;
+        sample = calculateLattice (sample, decayDiffusion2, decayDiffusion2R);
+
+        processDelay (sample, delayRight2);
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::advanceLfo (int numSamples)
+{
+    // rotate the quadrature pair, then pull it back onto the unit circle
+    auto angle = MathConstants<double>::twoPi * modulationRate * numSamples / currentSampleRate;
+    auto rotationCos = (float) std::cos (angle);
+    auto rotationSin = (float) std::sin (angle);
+
+    auto sine = lfoSine * rotationCos + lfoCosine * rotationSin;
+    auto cosine = lfoCosine * rotationCos - lfoSine * rotationSin;
+    auto magnitude = std::sqrt (sine * sine + cosine * cosine);
+
+    lfoSine = sine / magnitude;
+    lfoCosine = cosine / magnitude;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processLatticeBlock (SampleType* samples, int numSamples, SampleType coefficient, InputDelayLine& delayLine)
+{
+    delayLine.processBlock (samples, numSamples, delayLine.getLength(),
+                            [coefficient] (SampleType sample, SampleType delayOutput, SampleType& delayInput)
+                            {
+                                delayInput = sample - (delayOutput * coefficient);
+                                return delayInput * coefficient + delayOutput;
+                            });
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processOnepoleBlock (SampleType* samples, int numSamples, SampleType coefficient, OnepoleState<SampleType>& state)
+{
+    // recursive, so this one can't be vectorised
+    for (int i = 0; i < numSamples; ++i)
+    {
+        SampleType output = state.getOutput() * coefficient + samples[i];
+        state.pushSample (output);
+        samples[i] = output;
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+TankType PlateReverb<SampleType, TankType, halfPrecisionDelays>::calculateLattice (TankType sample, TankType coefficient, TankDelayLine& delayLine)
+{
+    TankType delayOutput = delayLine.getOutput();
+    TankType delayInput = sample - (delayOutput * coefficient);
+    TankType output = delayInput * coefficient + delayOutput;
+    delayLine.pushSample (delayInput);
+
+    return output;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+template <typename DelayLineType>
+TankType PlateReverb<SampleType, TankType, halfPrecisionDelays>::calculateReverseLattice (TankType sample, TankType coefficient, DelayLineType& delayLine)
+{
+    TankType delayOutput = delayLine.getOutput();
+    TankType delayInput = sample + (delayOutput * coefficient);
+    TankType output = delayOutput - (delayInput * coefficient);
+    delayLine.pushSample (delayInput);
+
+    return output;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+TankType PlateReverb<SampleType, TankType, halfPrecisionDelays>::calculateModulatedReverseLattice (TankType sample, TankType coefficient, TankType delayInSamples, ModulatedDelayLine& delayLine)
+{
+    TankType delayOutput = delayLine.getSample (delayInSamples);
+    TankType delayInput = sample + (delayOutput * coefficient);
+    TankType output = delayOutput - (delayInput * coefficient);
+    delayLine.pushSample (delayInput);
+
+    return output;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+TankType PlateReverb<SampleType, TankType, halfPrecisionDelays>::calculateOnepole (TankType sample, TankType coefficient, OnepoleState<TankType>& state)
+{
+    TankType output = state.getOutput() * coefficient + sample;
+    state.pushSample (output);
+
+    return output;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+TankType PlateReverb<SampleType, TankType, halfPrecisionDelays>::processDelay (TankType sample, LongDelayLine& delayLine)
+{
+    TankType delayOutput = delayLine.getOutput();
+    delayLine.pushSample (sample);
+    
+    return delayOutput;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+float PlateReverb<SampleType, TankType, halfPrecisionDelays>::getDecayDiffusion2 (float decay)
+{
+    return clamp (0.25f, 0.5f, decay + 0.15);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+double PlateReverb<SampleType, TankType, halfPrecisionDelays>::getTailLengthSeconds() const
+{
+    auto decayTarget = decaySmoother.getTargetValue();
+    auto decayDiffusion1Target = decayDiffusion1Smoother.getTargetValue();
+    auto decayDiffusion2Target = getDecayDiffusion2 (decayTarget);
+
+    // time for the input to reach the tank
+    auto inputMilliseconds = double (predelaySmoother.getTargetValue())
+                           + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::inputDiffusion1A, inputDiffusion1Smoother.getTargetValue())
+                           + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::inputDiffusion1B, inputDiffusion1Smoother.getTargetValue())
+                           + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::inputDiffusion2A, inputDiffusion2Smoother.getTargetValue())
+                           + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::inputDiffusion2B, inputDiffusion2Smoother.getTargetValue());
+
+    // one trip around both tank halves, modulation can stretch the first diffusers by their excursion
+    auto loopMilliseconds = double (2.0f * DattorroTopology::maximumExcursionMilliseconds)
+                          + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::decayDiffusion1L, decayDiffusion1Target)
+                          + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::decayDiffusion1R, decayDiffusion1Target)
+                          + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::decayDiffusion2L, decayDiffusion2Target)
+                          + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::decayDiffusion2R, decayDiffusion2Target);
+
+    for (int i = 0; i < DattorroTopology::numDelays; ++i)
+        if (DattorroTopology::isTankDelay ((DelayId) i))
+            loopMilliseconds += DattorroTopology::delayTimesMilliseconds[i];
+
+    // damping only takes away high frequencies, so the low end decays by the
+    // plain loop gain. a sustained input can build up to 1 / (1 - loopGain) first
+    auto loopGain = std::pow (double (decayTarget), double (DattorroTopology::decayGainsPerTankLoop));
+    auto buildupDecibels = -Decibels::gainToDecibels (1.0 - loopGain, -200.0);
+    auto lossPerLoopDecibels = -Decibels::gainToDecibels (loopGain, -200.0);
+    auto thresholdDecibels = Decibels::gainToDecibels (double (silenceThreshold), -200.0);
+
+    auto numLoops = (buildupDecibels - thresholdDecibels) / lossPerLoopDecibels;
+
+    // plus the pass that first carries the signal from the tank input to the output taps
+    auto tankMilliseconds = (numLoops + 1.0) * loopMilliseconds;
+
+    // a diffuser with a coefficient close to 1 keeps ringing on its own even once the loop gain is tiny
+    auto ringingMilliseconds = DattorroTopology::delayTimesMilliseconds[DelayId::decayDiffusion1R]
+                             * (buildupDecibels - thresholdDecibels)
+                             / -Decibels::gainToDecibels (double (decayDiffusion1Target), -200.0);
+
+    return (inputMilliseconds + jmax (tankMilliseconds, ringingMilliseconds)) / 1000.0;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+int PlateReverb<SampleType, TankType, halfPrecisionDelays>::clampTap (int tapInSamples, int delayInSamples)
+{
+    // output taps are read one sample behind the write head
+    jassert (tapInSamples >= 0 && tapInSamples < delayInSamples);
+    return clamp (0, delayInSamples - 1, tapInSamples);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+int PlateReverb<SampleType, TankType, halfPrecisionDelays>::clamp (int low, int high, int value)
+{
+    if (value < low)
+        return low;
+    else if (value > high)
+        return high;
+    else
+        return value;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+float PlateReverb<SampleType, TankType, halfPrecisionDelays>::clamp (float low, float high, float value)
+{
+    if (value < low)
+        return low;
+    else if (value > high)
+        return high;
+    else
+        return value;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setParameters (const Parameters& newParameters)
+{
+    setPredelayTime (newParameters.predelayTime);
+    setDecay (newParameters.decay);
+    setDecayDiffusion1 (newParameters.decayDiffusion1);
+    setInputDiffusion1 (newParameters.inputDiffusion1);
+    setInputDiffusion2 (newParameters.inputDiffusion2);
+    setBandwidth (newParameters.bandwidth);
+    setDamping (newParameters.damping);
+    setMix (newParameters.mix);
+    setModulationRate (newParameters.modulationRate);
+    setModulationDepth (newParameters.modulationDepth);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setPredelayTime (float newPredelayTime)
+{
+    predelaySmoother.setTargetValue (clamp (0.0f, 1000.0f, newPredelayTime));
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setDecay (float newDecay)
+{
+    decaySmoother.setTargetValue (clamp (0.01f, 0.99f, newDecay));
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setDecayDiffusion1 (float newDecayDiffusion1)
+{
+    decayDiffusion1Smoother.setTargetValue (clamp (0.01f, 0.99f, newDecayDiffusion1));
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setInputDiffusion1 (float newInputDiffusion1)
+{
+    inputDiffusion1Smoother.setTargetValue (clamp(0.01f, 0.99f, newInputDiffusion1));
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setInputDiffusion2 (float newInputDiffusion2)
+{
+    inputDiffusion2Smoother.setTargetValue (clamp(0.01f, 0.99f, newInputDiffusion2));
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setBandwidth (float newBandwidth)
+{
+    bandwidthSmoother.setTargetValue (clamp (0.0000001f, 0.9999999f, newBandwidth));
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setDamping (float newDamping)
+{
+    dampingSmoother.setTargetValue (clamp (0.0f, 0.9999999f, newDamping));
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setMix(float newMix)
+{
+    mixSmoother.setTargetValue (clamp (0.0f, 1.0f, newMix));
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setModulationRate (float newModulationRate)
+{
+    modulationRate = clamp (0.01f, 10.0f, newModulationRate);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setModulationDepth (float newModulationDepth)
+{
+    modulationDepthSmoother.setTargetValue (clamp (0.0f, 1.0f, newModulationDepth));
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setSilenceThreshold (float newThresholdDecibels)
+{
+    // decibelsToGain treats anything below its floor as silence, so pass one lower than ours
+    silenceThreshold = Decibels::decibelsToGain (clamp (-180.0f, 0.0f, newThresholdDecibels), -200.0f);
+}
+
+template class PlateReverb<float>;
+template class PlateReverb<double>;
+template class PlateReverb<float, double>;
+template class PlateReverb<float, float, true>;
+template class PlateReverb<float, double, true>;
+
+} // namespace Reference
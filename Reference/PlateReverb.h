@@ -0,0 +1,321 @@
+/*
+  ==============================================================================
+
+    PlateReverb.h
+    Created: 17 May 2024 12:00:32pm
+    Author:  Till
+
+    Frozen copy of Source/Reverb as the reference the equivalence tool
+    checks optimised engines against. Leave it alone: its output is the
+    definition of how the plate is supposed to sound.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "DelayLine.h"
+#include "DattorroTopology.h"
+
+namespace Reference
+{
+
+// a consistent set of all parameter values, in their plain units
+struct PlateReverbParameters
+{
+    float predelayTime = 0.0f;
+    float decay = 0.5f;
+    float decayDiffusion1 = 0.7f;
+    float inputDiffusion1 = 0.75f;
+    float inputDiffusion2 = 0.625f;
+    float bandwidth = 0.9995f;
+    float damping = 0.0005f;
+    float mix = 0.5f;
+    float modulationRate = 1.0f;
+    float modulationDepth = 0.0f;
+};
+
+/*
+    SampleType is the precision of the audio passed in and out and of the
+    feed-forward input chain. TankType is the precision of the recirculating
+    tank, the only part where rounding errors accumulate, so
+    PlateReverb<float, double> keeps float I/O with a double-precision tail.
+
+    halfPrecisionDelays stores the predelay and the four long tank delays,
+    the bulk of the engine's memory, as HalfFloat instead. That roughly
+    halves the footprint at the cost of a noise floor about 60 dB below
+    the wet signal.
+
+    Instantiated for <float>, <double>, <float, double>, <float, float, true>
+    and <float, double, true>.
+*/
+template <typename SampleType, typename TankType = SampleType, bool halfPrecisionDelays = false>
+class PlateReverb
+{
+public:
+    using Parameters = PlateReverbParameters;
+
+    PlateReverb();
+    
+    void prepareToPlay (double sampleRate, int maximumBlockSize);
+
+    /*  Sizes all storage for up to this sample rate and block size from the
+        next prepareToPlay on, so preparing again within them only re-indexes
+        the storage already there instead of allocating. 0 sizes for each
+        prepareToPlay call alone.
+    */
+    void reserve (double maximumSampleRate, int maximumBlockSize);
+
+    // frees every delay line and scratch buffer, prepareToPlay has to run again before processing
+    void releaseResources();
+
+    void processBlock (juce::AudioBuffer<SampleType>& buffer, int numSamples, int numChannels);
+
+    // applies a whole snapshot, the coefficients ramp to their new values at control rate
+    void setParameters (const Parameters& newParameters);
+
+    // setter functions for gui tests
+
+    // in milliseconds, 0 .. 1000. the tap glides to a new time instead of jumping
+    void setPredelayTime (float newPredelayTime);
+
+    void setDecay (float newDecay);
+
+    void setDecayDiffusion1 (float newDecyDiffusion1);
+
+    void setInputDiffusion1 (float newInputDiffusion1);
+
+    void setInputDiffusion2 (float newInputDiffusion2);
+
+    void setBandwidth (float newBandwidth);
+
+    void setDamping (float newDamping);
+
+    void setMix (float newMix);
+
+    // LFO rate in Hz of the tank modulation
+    void setModulationRate (float newModulationRate);
+
+    // 0 .. 1 of Dattorro's maximum excursion, 0 switches modulation off
+    void setModulationDepth (float newModulationDepth);
+
+    // level below which input and tail count as silence, in dBFS
+    void setSilenceThreshold (float newThresholdDecibels);
+
+    /*  True while the tank is asleep: the tail has decayed below the silence
+        threshold, so the network is cleared and skipped until the input
+        rises above it again. Safe to poll from any thread.
+    */
+    bool isSleeping() const noexcept { return sleeping.load (std::memory_order_relaxed); }
+
+    /*  Estimated time a full-scale input needs to ring out below the silence
+        threshold, for the current parameter targets. Errs on the long side:
+        every allpass is assumed to hold energy for its longest group delay.
+    */
+    double getTailLengthSeconds() const;
+
+    // bytes this instance occupies, including the delay line arena and scratch buffers
+    size_t getFootprintInBytes() const;
+
+private:
+    // interpolation used by the modulated decay diffusers
+    using ModulationInterpolation = DelayInterpolation::Cubic;
+
+    using InputDelayLine = DelayLine<SampleType>;
+    using TankDelayLine = DelayLine<TankType>;
+    using ModulatedDelayLine = DelayLine<TankType, ModulationInterpolation>;
+
+    template <typename Type>
+    using LongDelayStorage = std::conditional_t<halfPrecisionDelays, HalfFloat, Type>;
+
+    // interpolation used by the predelay tap while it glides
+    using PredelayInterpolation = DelayInterpolation::Linear;
+
+    using PredelayLine = DelayLine<SampleType, PredelayInterpolation, LongDelayStorage<SampleType>>;
+    using LongDelayLine = DelayLine<TankType, DelayInterpolation::None, LongDelayStorage<TankType>>;
+
+    /*  History of a one-pole filter, kept in the engine object instead of a
+        delay line of its own. The feedback is read two samples back, as the
+        original engine did with its 2-sample delay lines.
+    */
+    template <typename Type>
+    struct OnepoleState
+    {
+        Type getOutput() const noexcept { return history[(size_t) index]; }
+
+        void pushSample (Type sample) noexcept
+        {
+            history[(size_t) index] = sample;
+            index ^= 1;
+        }
+
+        void clear() noexcept
+        {
+            history = {};
+            index = 0;
+        }
+
+        std::array<Type, 2> history{};
+        int index{ 0 };
+    };
+
+    // calls visit (delayLine, delayInSamples, extraCapacity) for every line in DattorroTopology::processingOrder
+    template <typename Visitor>
+    void visitDelayLines (double sampleRate, int blockSize, Visitor&& visit);
+
+    // arena bytes the whole network takes at this rate and block size
+    size_t getArenaSize (double sampleRate, int blockSize);
+
+    void allocateDelayLines (double sampleRate, int blockSize, size_t storageSize);
+
+    template <typename DelayLineType>
+    static size_t getStorageBytes (int delayInSamples, int extraCapacity);
+
+    static int getExcursionSamples (double sampleRate);
+
+    void processPredelay (SampleType* samples, int numSamples);
+
+    void processInputChain (const SampleType* inputLeft, const SampleType* inputRight, SampleType* output, int numSamples);
+
+    void processTank (const SampleType* input, SampleType* outputLeft, SampleType* outputRight, int numSamples);
+
+    void gatherOutputTaps (SampleType* outputLeft, SampleType* outputRight, int numSamples);
+
+    void addOutputTap (SampleType* output, int numSamples, DattorroTopology::DelayId id, int tapInSamples, SampleType gain);
+
+    template <bool modulated>
+    void processTankSamples (const SampleType* input, int numSamples);
+
+    void advanceLfo (int numSamples);
+
+    void processLatticeBlock (SampleType* samples, int numSamples, SampleType coefficient, InputDelayLine& delayLine);
+
+    void processOnepoleBlock (SampleType* samples, int numSamples, SampleType coefficient, OnepoleState<SampleType>& state);
+
+    TankType calculateLattice (TankType sample, TankType coefficient, TankDelayLine& delayLine);
+
+    template <typename DelayLineType>
+    TankType calculateReverseLattice (TankType sample, TankType coefficient, DelayLineType& delayLine);
+
+    TankType calculateModulatedReverseLattice (TankType sample, TankType coefficient, TankType delayInSamples, ModulatedDelayLine& delayLine);
+
+    TankType calculateOnepole (TankType sample, TankType coefficient, OnepoleState<TankType>& state);
+
+    TankType processDelay (TankType sample, LongDelayLine& delayLine);
+
+    void updateCoefficients (int numSamples);
+
+    void updateSilenceTracking (SampleType inputPeak, const SampleType* outputLeft, const SampleType* outputRight, int numSamples);
+
+    void clearDelayLines();
+
+    bool isSmoothing() const;
+
+    int clampTap (int tapInSamples, int delayInSamples);
+
+    static float getDecayDiffusion2 (float decay);
+
+    static int clamp (int low, int high, int value);
+
+    static float clamp (float low, float high,  float value);
+
+    // parameters, the input chain and mix run at the I/O precision and the tank at its own
+    TankType decay;
+    TankType decayDiffusion1;
+    TankType decayDiffusion2;
+    SampleType inputDiffusion1;
+    SampleType inputDiffusion2;
+    SampleType bandwidth;
+    TankType damping;
+    SampleType mix;
+
+    // parameter ramps, the values above are advanced from these once per control block
+    static constexpr int controlRateInterval = 32;
+    static constexpr double smoothingTimeSeconds = 0.05;
+
+    SmoothedValue<float> decaySmoother;
+    SmoothedValue<float> decayDiffusion1Smoother;
+    SmoothedValue<float> inputDiffusion1Smoother;
+    SmoothedValue<float> inputDiffusion2Smoother;
+    SmoothedValue<float> bandwidthSmoother;
+    SmoothedValue<float> dampingSmoother;
+    SmoothedValue<float> mixSmoother;
+
+    // the predelay tap in milliseconds, ramped per sample. long enough that
+    // sweeping across the whole range glides instead of crackling
+    static constexpr double predelaySmoothingTimeSeconds = 0.2;
+
+    SmoothedValue<float> predelaySmoother;
+
+    // tank modulation, a quadrature LFO advanced once per lfoUpdateInterval
+    // samples with the delay times ramped linearly in between
+    static constexpr int lfoUpdateInterval = 128;
+
+    float modulationRate;
+    float modulationDepth;
+    SmoothedValue<float> modulationDepthSmoother;
+    float maximumExcursionSamples{ 0.0f };
+    float lfoSine{ 0.0f };
+    float lfoCosine{ 1.0f };
+
+    // silence detection. the tank goes to sleep once input and wet output have
+    // stayed below the threshold for long enough to drain the whole network
+    static constexpr float defaultSilenceThresholdDecibels = -120.0f;
+
+    SampleType silenceThreshold;
+    int samplesBelowThreshold{ 0 };
+    int networkDrainSamples{ 0 };
+    std::atomic<bool> sleeping{ false };
+
+    double currentSampleRate{ 0.0 };
+
+    // per-block scratch space
+    enum BlockChannel
+    {
+        tankInputChannel,
+        outputLeftChannel,
+        outputRightChannel,
+        numBlockChannels
+    };
+
+    AudioBuffer<SampleType> blockBuffer;
+    int maximumBlockSize{ 0 };
+
+    PredelayLine predelayLine;
+
+    // the input diffusers' delay lines, indexed by DattorroTopology::DelayId.
+    // the other slots stay unused
+    std::array<InputDelayLine, DattorroTopology::numDelays> inputDelayLines;
+
+    // the four long tank delays, indexed the same way
+    std::array<LongDelayLine, DattorroTopology::numDelays> longDelayLines;
+
+    // the unmodulated decay diffusers, indexed the same way
+    std::array<TankDelayLine, DattorroTopology::numDelays> delayLines;
+
+    ModulatedDelayLine decayDiffusion1L;
+    ModulatedDelayLine decayDiffusion1R;
+
+    OnepoleState<SampleType> bandwidthOnepole;
+    OnepoleState<TankType> dampingOnepoleLeft;
+    OnepoleState<TankType> dampingOnepoleRight;
+
+    // storage of every delay line above, one cache-aligned block laid out in
+    // DattorroTopology::processingOrder
+    static constexpr size_t cacheLineSize = 64;
+
+    HeapBlock<char> arena;
+    size_t arenaSize{ 0 };
+
+    double reservedSampleRate{ 0.0 };
+    int reservedBlockSize{ 0 };
+
+    // output tap delay times in samples
+
+    std::array<int, DattorroTopology::numTapsPerChannel> samplesLeftOutputTaps;
+    std::array<int, DattorroTopology::numTapsPerChannel> samplesRightOutputTaps;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PlateReverb)
+};
+
+} // namespace Reference
@@ -0,0 +1,253 @@
+/*
+  ==============================================================================
+
+    EngineCrossfade.h
+
+    The engine playing, plus a spare one prepared alongside it. At a preset
+    change the spare crossfades in from the old engine's tail, and the
+    engine it replaced becomes the spare once the fade is over, after the
+    message thread has cleared it. Switching presets never allocates or
+    clears a whole engine on the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LevelMeter.h"
+
+template <typename EngineType, typename SampleType>
+class EngineCrossfade
+{
+public:
+    EngineCrossfade() : playing (std::make_unique<EngineType>()) {}
+
+    ~EngineCrossfade()
+    {
+        delete spare.exchange (nullptr, std::memory_order_acq_rel);
+        delete returned.exchange (nullptr, std::memory_order_acq_rel);
+    }
+
+    // the engine the output ends up coming from. parameter changes and per-block settings go to this one
+    EngineType& get() noexcept { return *playing; }
+    const EngineType& get() const noexcept { return *playing; }
+
+    // in seconds, from the next prepare on. 0 applies presets to the playing engine, ramping like any parameter change
+    void setTransitionTime (double newTransitionSeconds) noexcept { transitionSeconds = jmax (0.0, newTransitionSeconds); }
+
+    double getTransitionTime() const noexcept { return transitionSeconds; }
+
+    /*  Sizes the input copy for the engine fading out, and creates the
+        spare the first time crossfades are on. Call while the audio thread
+        is stopped, then prepare get() and getSpare() the same way.
+    */
+    void prepare (double sampleRate, int newMaximumBlockSize)
+    {
+        maximumBlockSize = jmax (1, newMaximumBlockSize);
+        scratch.setSize (2, maximumBlockSize, false, false, true);
+
+        transitionSamples = roundToInt (transitionSeconds * sampleRate);
+        fadeSamplesRemaining = 0;
+
+        auto engine = gatherSpare();
+
+        if (transitionSamples <= 0)
+            engine.reset();
+        else if (engine == nullptr)
+            engine = std::make_unique<EngineType>();
+
+        spare.store (engine.release(), std::memory_order_release);
+    }
+
+    // the engine the next preset change fades into, nullptr with crossfades off. only while the audio thread is stopped
+    EngineType* getSpare() noexcept { return spare.load (std::memory_order_acquire); }
+
+    void releaseResources()
+    {
+        playing->releaseResources();
+
+        // the spare is kept, only its storage goes until the next prepare
+        if (auto engine = gatherSpare())
+        {
+            engine->releaseResources();
+            spare.store (engine.release(), std::memory_order_release);
+        }
+
+        scratch.setSize (0, 0);
+        fadeSamplesRemaining = 0;
+    }
+
+    /*  Clears the engine that last faded out and makes it the spare again,
+        from any thread but the audio thread. Until this has run, a preset
+        change ramps the playing engine instead of crossfading.
+    */
+    void recycleSpare()
+    {
+        if (auto* engine = returned.exchange (nullptr, std::memory_order_acq_rel))
+        {
+            engine->reset();
+            spare.store (engine, std::memory_order_release);
+        }
+    }
+
+    /*  Called on the audio thread: sets the spare to the new parameters and
+        fades over to it. Returns false if there is no tail to fade from, the
+        last crossfade is still running or the spare isn't cleared yet, or
+        crossfades are off. The playing engine then takes the parameters as
+        usual.
+    */
+    template <typename Parameters>
+    bool beginTransition (const Parameters& parameters)
+    {
+        if (transitionSamples <= 0 || outgoing != nullptr || get().isSleeping())
+            return false;
+
+        auto* incoming = spare.exchange (nullptr, std::memory_order_acq_rel);
+
+        if (incoming == nullptr)
+            return false;
+
+        outgoing = std::move (playing);
+        playing.reset (incoming);
+
+        // the spare is empty already, it only has to start out at the new values instead of ramping there
+        playing->setParameters (parameters);
+        playing->skipSmoothing();
+
+        fadeSamplesRemaining = transitionSamples;
+        return true;
+    }
+
+    bool isTransitioning() const noexcept { return fadeSamplesRemaining > 0; }
+
+    // true once the playing engine and any engine still fading out have both gone to sleep
+    bool isSleeping() const noexcept
+    {
+        return get().isSleeping() && (fadeSamplesRemaining <= 0 || outgoing->isSleeping());
+    }
+
+    // as EngineType::setMeteringEnabled, for the engine fading out as well
+    void setMeteringEnabled (bool shouldMeter) noexcept
+    {
+        playing->setMeteringEnabled (shouldMeter);
+
+        if (outgoing != nullptr)
+            outgoing->setMeteringEnabled (shouldMeter);
+    }
+
+    // as EngineType::processBlock. the spare only costs CPU for the blocks a crossfade covers
+    void processBlock (AudioBuffer<SampleType>& buffer, int numSamples, int numChannels)
+    {
+        metered = {};
+
+        auto numFadeSamples = jmin (numSamples, fadeSamplesRemaining);
+
+        // the engine fading out renders from a copy of the input, in pieces the size of that copy
+        for (int startSample = 0; startSample < numFadeSamples; startSample += maximumBlockSize)
+        {
+            auto blockSize = jmin (maximumBlockSize, numFadeSamples - startSample);
+            AudioBuffer<SampleType> block (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), startSample, blockSize);
+
+            processFade (block, blockSize, numChannels);
+        }
+
+        if (numFadeSamples < numSamples)
+        {
+            AudioBuffer<SampleType> rest (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numFadeSamples, numSamples - numFadeSamples);
+            get().processBlock (rest, numSamples - numFadeSamples, numChannels);
+
+            LevelMeter::combine (metered, { get().getLevels(), numSamples - numFadeSamples });
+        }
+    }
+
+    // levels of the last processBlock call as a whole, through a crossfade those of the faded output
+    const PlateReverbLevels& getLevels() const noexcept { return metered.levels; }
+
+private:
+    void processFade (AudioBuffer<SampleType>& block, int numSamples, int numChannels)
+    {
+        auto numFadeChannels = jmin (numChannels, scratch.getNumChannels());
+
+        for (int channel = 0; channel < numFadeChannels; ++channel)
+            scratch.copyFrom (channel, 0, block, channel, 0, numSamples);
+
+        outgoing->processBlock (scratch, numSamples, numFadeChannels);
+        get().processBlock (block, numSamples, numChannels);
+
+        // both engines carry the same dry signal, which a linear fade keeps at unity gain
+        auto step = SampleType (1.0) / SampleType (transitionSamples);
+        auto startGain = SampleType (fadeSamplesRemaining) * step;
+
+        for (int channel = 0; channel < numFadeChannels; ++channel)
+        {
+            auto* output = block.getWritePointer (channel);
+            auto* fading = scratch.getReadPointer (channel);
+
+            for (int i = 0; i < numSamples; ++i)
+                output[i] += (fading[i] - output[i]) * (startGain - SampleType (i) * step);
+        }
+
+        meterFade ((float) (startGain - SampleType (numSamples - 1) * SampleType (0.5) * step), numSamples);
+
+        fadeSamplesRemaining -= numSamples;
+
+        // the engine that faded out is cleared on another thread, then it is the spare again
+        if (fadeSamplesRemaining <= 0)
+        {
+            jassert (returned.load (std::memory_order_acquire) == nullptr);
+            returned.store (outgoing.release(), std::memory_order_release);
+        }
+    }
+
+    // both engines' wet and tank levels weighted by their mean gain over the piece, the input is the same for both
+    void meterFade (float outgoingGain, int numSamples) noexcept
+    {
+        const auto& fadingOut = outgoing->getLevels();
+        auto levels = get().getLevels();
+        auto incomingGain = 1.0f - outgoingGain;
+
+        levels.wetPeak = outgoingGain * fadingOut.wetPeak + incomingGain * levels.wetPeak;
+        levels.wetRms = outgoingGain * fadingOut.wetRms + incomingGain * levels.wetRms;
+        levels.tankPeak = outgoingGain * fadingOut.tankPeak + incomingGain * levels.tankPeak;
+        levels.tankRms = outgoingGain * fadingOut.tankRms + incomingGain * levels.tankRms;
+
+        LevelMeter::combine (metered, { levels, numSamples });
+    }
+
+    // while the audio thread is stopped: the spare wherever it is, waiting, fading out or cleared
+    std::unique_ptr<EngineType> gatherSpare()
+    {
+        std::unique_ptr<EngineType> engine (spare.exchange (nullptr, std::memory_order_acq_rel));
+
+        if (engine == nullptr)
+            engine.reset (returned.exchange (nullptr, std::memory_order_acq_rel));
+
+        // a fade that was cut short, prepareToPlay clears the engine again
+        if (engine == nullptr)
+            engine = std::move (outgoing);
+
+        jassert (outgoing == nullptr && returned.load() == nullptr);
+        return engine;
+    }
+
+    std::unique_ptr<EngineType> playing;
+
+    // the engine fading out. besides playing there is only ever one engine, here or in one of the slots
+    std::unique_ptr<EngineType> outgoing;
+
+    // the cleared spare, taken by the audio thread, and the faded-out engine it hands back to be cleared
+    std::atomic<EngineType*> spare{ nullptr };
+    std::atomic<EngineType*> returned{ nullptr };
+
+    AudioBuffer<SampleType> scratch;
+    int maximumBlockSize{ 1 };
+
+    double transitionSeconds{ 0.0 };
+    int transitionSamples{ 0 };
+    int fadeSamplesRemaining{ 0 };
+
+    LevelMeter::Frame metered;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EngineCrossfade)
+};
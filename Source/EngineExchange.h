@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    EngineExchange.h
+
+    Owns the engine the audio thread plays through and lets a replacement
+    be prepared on another thread, then swapped in between two blocks
+    without locking or allocating on the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template <typename EngineType>
+class EngineExchange
+{
+public:
+    EngineExchange() : active (new EngineType()) {}
+
+    ~EngineExchange()
+    {
+        discardPending();
+        collectGarbage();
+        delete active.load (std::memory_order_acquire);
+    }
+
+    // the engine currently playing. only touch it from the audio thread, or while that is stopped
+    EngineType& get() noexcept { return *active.load (std::memory_order_relaxed); }
+    const EngineType& get() const noexcept { return *active.load (std::memory_order_relaxed); }
+
+    /*  Hands over a fully prepared engine, from any thread but the audio
+        thread. A replacement that the audio thread hasn't picked up yet is
+        dropped in favour of this one.
+    */
+    void submit (std::unique_ptr<EngineType> prepared)
+    {
+        collectGarbage();
+        std::unique_ptr<EngineType> superseded (pending.exchange (prepared.release(), std::memory_order_acq_rel));
+    }
+
+    // drops a replacement that hasn't been picked up yet, e.g. once the host prepares the active engine itself
+    void discardPending()
+    {
+        std::unique_ptr<EngineType> superseded (pending.exchange (nullptr, std::memory_order_acq_rel));
+    }
+
+    /*  Called by the audio thread at the start of a block, switches to a
+        submitted engine if there is one. Freeing the old engine here could
+        block, and so could posting a message, so it is only parked for
+        collectGarbage(). Until that has run no further swap happens.
+    */
+    bool swapIfPending() noexcept
+    {
+        // the previous swap hasn't been collected yet, try again next block
+        if (retired.load (std::memory_order_acquire) != nullptr)
+            return false;
+
+        auto* next = pending.exchange (nullptr, std::memory_order_acq_rel);
+
+        if (next == nullptr)
+            return false;
+
+        retired.store (active.load (std::memory_order_relaxed), std::memory_order_release);
+        active.store (next, std::memory_order_release);
+
+        return true;
+    }
+
+    /*  Frees the engine the audio thread swapped out, from any thread but
+        the audio thread. The owner polls this, e.g. from a timer, so a swap
+        is collected soon after it happened.
+    */
+    void collectGarbage()
+    {
+        const ScopedLock sl (garbageLock);
+        std::unique_ptr<EngineType> old (retired.exchange (nullptr, std::memory_order_acq_rel));
+    }
+
+    /*  Calls function with the engine currently playing, from any thread but
+        the audio thread. It can't be freed during the call, but the audio
+        thread may be running it or swap it out meanwhile, so function may
+        only use the parts of it meant to be shared between threads.
+    */
+    template <typename Function>
+    void visitActive (Function&& function)
+    {
+        // an engine the audio thread swaps out meanwhile waits in retired, which only collectGarbage() empties
+        const ScopedLock sl (garbageLock);
+        function (*active.load (std::memory_order_acquire));
+    }
+
+private:
+    std::atomic<EngineType*> active;
+    std::atomic<EngineType*> pending{ nullptr };
+    std::atomic<EngineType*> retired{ nullptr };
+
+    // only ever taken off the audio thread
+    CriticalSection garbageLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EngineExchange)
+};
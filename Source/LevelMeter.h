@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    LevelMeter.h
+
+    Carries the engine's block levels from the audio thread to the editor.
+    The audio thread writes them into a single-producer, single-consumer
+    FIFO that never blocks or allocates, the editor folds whatever arrived
+    since its last look into one reading.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Reverb/PlateReverb.h"
+
+class LevelMeter
+{
+public:
+    LevelMeter() : fifo (capacity) {}
+
+    // true while a reader is attached, the audio thread only measures then
+    bool isActive() const noexcept { return active.load (std::memory_order_relaxed); }
+
+    // from the reading thread, drops whatever was left over from an earlier reader
+    void startReading()
+    {
+        Frame discarded;
+        pullFrames (discarded);
+        active.store (true, std::memory_order_relaxed);
+    }
+
+    void stopReading() noexcept { active.store (false, std::memory_order_relaxed); }
+
+    /*  Called by the audio thread after every block. When the reader has
+        fallen so far behind that the FIFO is full, the block is held back
+        and combined with the next one instead of blocking.
+    */
+    void push (const PlateReverbLevels& levels, int numSamples) noexcept
+    {
+        combine (heldBack, { levels, numSamples });
+
+        auto scope = fifo.write (1);
+
+        if (scope.blockSize1 > 0)
+            frames[(size_t) scope.startIndex1] = heldBack;
+        else if (scope.blockSize2 > 0)
+            frames[(size_t) scope.startIndex2] = heldBack;
+        else
+            return;
+
+        heldBack = {};
+    }
+
+    // from the reading thread, everything pushed since the last call combined. false if nothing arrived
+    bool pull (PlateReverbLevels& levels)
+    {
+        Frame combined;
+
+        if (! pullFrames (combined))
+            return false;
+
+        levels = combined.levels;
+        return true;
+    }
+
+    // levels over numSamples samples
+    struct Frame
+    {
+        PlateReverbLevels levels;
+        int numSamples = 0;
+    };
+
+    // adds frame to the running total. peaks take the maximum, RMS levels are weighted by the samples they cover
+    static void combine (Frame& into, const Frame& frame) noexcept
+    {
+        auto total = into.numSamples + frame.numSamples;
+
+        if (total == 0)
+            return;
+
+        auto combineRms = [&] (float a, float b)
+        {
+            return std::sqrt ((a * a * (float) into.numSamples + b * b * (float) frame.numSamples) / (float) total);
+        };
+
+        auto& l = into.levels;
+        const auto& r = frame.levels;
+
+        l.inputPeak = jmax (l.inputPeak, r.inputPeak);
+        l.inputRms = combineRms (l.inputRms, r.inputRms);
+        l.wetPeak = jmax (l.wetPeak, r.wetPeak);
+        l.wetRms = combineRms (l.wetRms, r.wetRms);
+        l.tankPeak = jmax (l.tankPeak, r.tankPeak);
+        l.tankRms = combineRms (l.tankRms, r.tankRms);
+
+        into.numSamples = total;
+    }
+
+private:
+    bool pullFrames (Frame& combined)
+    {
+        auto scope = fifo.read (fifo.getNumReady());
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            combine (combined, frames[(size_t) (scope.startIndex1 + i)]);
+
+        for (int i = 0; i < scope.blockSize2; ++i)
+            combine (combined, frames[(size_t) (scope.startIndex2 + i)]);
+
+        return scope.blockSize1 + scope.blockSize2 > 0;
+    }
+
+    // about 0.7 s of 32 sample blocks at 48 kHz, the editor reads many times a second
+    static constexpr int capacity = 1024;
+
+    AbstractFifo fifo;
+    std::array<Frame, capacity> frames;
+    std::atomic<bool> active{ false };
+
+    // audio thread only
+    Frame heldBack;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeter)
+};
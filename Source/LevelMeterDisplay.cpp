@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    LevelMeterDisplay.cpp
+
+  ==============================================================================
+*/
+
+#include "LevelMeterDisplay.h"
+
+LevelMeterDisplay::LevelMeterDisplay (LevelMeter& meterToShow)
+    : meter (meterToShow)
+{
+    meter.startReading();
+    startTimerHz (refreshRateHz);
+}
+
+LevelMeterDisplay::~LevelMeterDisplay()
+{
+    stopTimer();
+    meter.stopReading();
+}
+
+void LevelMeterDisplay::timerCallback()
+{
+    PlateReverbLevels levels;
+
+    // nothing arrived, e.g. while the host is stopped, so the bars just fall back
+    if (! meter.pull (levels))
+        levels = {};
+
+    updateBar (input, levels.inputPeak, levels.inputRms);
+    updateBar (wet, levels.wetPeak, levels.wetRms);
+    updateBar (tank, levels.tankPeak, levels.tankRms);
+
+    repaint();
+}
+
+void LevelMeterDisplay::updateBar (Bar& bar, float newPeak, float newRms)
+{
+    // rises at once, falls back slowly enough to read
+    auto fallback = fallbackDecibelsPerSecond / (float) refreshRateHz;
+
+    auto peakDecibels = Decibels::gainToDecibels (newPeak, minimumDecibels);
+    auto rmsDecibels = Decibels::gainToDecibels (newRms, minimumDecibels);
+
+    bar.peak = jmax (peakDecibels, bar.peak - fallback, minimumDecibels);
+    bar.rms = jmax (rmsDecibels, bar.rms - fallback, minimumDecibels);
+}
+
+void LevelMeterDisplay::paint (juce::Graphics& g)
+{
+    auto area = getLocalBounds().toFloat();
+    auto barWidth = area.getWidth() / 3.0f;
+
+    paintBar (g, area.removeFromLeft (barWidth).reduced (4.0f, 0.0f), input);
+    paintBar (g, area.removeFromLeft (barWidth).reduced (4.0f, 0.0f), wet);
+    paintBar (g, area.reduced (4.0f, 0.0f), tank);
+}
+
+void LevelMeterDisplay::paintBar (juce::Graphics& g, juce::Rectangle<float> area, const Bar& bar) const
+{
+    auto textColour = getLookAndFeel().findColour (juce::Label::textColourId);
+
+    g.setColour (textColour);
+    g.setFont (12.0f);
+    g.drawText (bar.name, area.removeFromBottom (16.0f), juce::Justification::centred);
+
+    g.setColour (textColour.withAlpha (0.15f));
+    g.fillRect (area);
+
+    auto toY = [&area] (float decibels)
+    {
+        return jmap (decibels, minimumDecibels, 0.0f, area.getBottom(), area.getY());
+    };
+
+    // RMS as the bar, peak as a line above it
+    g.setColour (juce::Colours::limegreen.withAlpha (0.8f));
+    g.fillRect (area.withTop (toY (jmin (bar.rms, 0.0f))));
+
+    g.setColour (bar.peak >= 0.0f ? juce::Colours::red : juce::Colours::yellow);
+    g.fillRect (area.withTop (toY (jmin (bar.peak, 0.0f))).withHeight (2.0f));
+}
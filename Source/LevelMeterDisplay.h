@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    LevelMeterDisplay.h
+
+    Bar meters for the input, the wet output and the tank, redrawn on a
+    timer from what the audio thread published through a LevelMeter.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LevelMeter.h"
+
+class LevelMeterDisplay  : public juce::Component,
+                           private juce::Timer
+{
+public:
+    explicit LevelMeterDisplay (LevelMeter& meterToShow);
+    ~LevelMeterDisplay() override;
+
+    void paint (juce::Graphics&) override;
+
+private:
+    void timerCallback() override;
+
+    // what one bar shows, in decibels
+    struct Bar
+    {
+        juce::String name;
+        float peak = minimumDecibels;
+        float rms = minimumDecibels;
+    };
+
+    void updateBar (Bar& bar, float newPeak, float newRms);
+
+    void paintBar (juce::Graphics& g, juce::Rectangle<float> area, const Bar& bar) const;
+
+    static constexpr float minimumDecibels = -60.0f;
+    static constexpr int refreshRateHz = 30;
+
+    // how fast the bars fall back once a level drops, in dB per second
+    static constexpr float fallbackDecibelsPerSecond = 24.0f;
+
+    LevelMeter& meter;
+
+    Bar input{ "In" };
+    Bar wet{ "Wet" };
+    Bar tank{ "Tank" };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeterDisplay)
+};
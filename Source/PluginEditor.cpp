@@ -11,11 +11,13 @@
 
 //==============================================================================
 NewProjectAudioProcessorEditor::NewProjectAudioProcessorEditor (DattorroReverbAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p), levelMeters (p.getLevelMeter())
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (520, 390);
+
+    addAndMakeVisible(levelMeters);
 
     addAndMakeVisible(predelayTimeSlider);
     predelayTimeAttachment =
@@ -88,10 +90,69 @@ NewProjectAudioProcessorEditor::NewProjectAudioProcessorEditor (DattorroReverbAu
     addAndMakeVisible(mixLabel);
     mixLabel.setText("Mix", juce::dontSendNotification);
     mixLabel.attachToComponent(&mixSlider, true);
+
+    addAndMakeVisible(modRateSlider);
+    modRateAttachment =
+        std::make_unique<AudioProcessorValueTreeState::SliderAttachment>
+        (audioProcessor.apvst, "modRate", modRateSlider);
+
+    addAndMakeVisible(modRateLabel);
+    modRateLabel.setText("Modulation Rate", juce::dontSendNotification);
+    modRateLabel.attachToComponent(&modRateSlider, true);
+
+    addAndMakeVisible(modDepthSlider);
+    modDepthAttachment =
+        std::make_unique<AudioProcessorValueTreeState::SliderAttachment>
+        (audioProcessor.apvst, "modDepth", modDepthSlider);
+
+    addAndMakeVisible(modDepthLabel);
+    modDepthLabel.setText("Modulation Depth", juce::dontSendNotification);
+    modDepthLabel.attachToComponent(&modDepthSlider, true);
+
+    // the attachment takes the items from the parameter, so they have to be there first
+    addAndMakeVisible(qualityBox);
+    qualityBox.addItemList(audioProcessor.apvst.getParameter("quality")->getAllValueStrings(), 1);
+    qualityAttachment =
+        std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>
+        (audioProcessor.apvst, "quality", qualityBox);
+
+    addAndMakeVisible(qualityLabel);
+    qualityLabel.setText("Quality", juce::dontSendNotification);
+    qualityLabel.attachToComponent(&qualityBox, true);
+
+    addAndMakeVisible(trueStereoButton);
+    trueStereoAttachment =
+        std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>
+        (audioProcessor.apvst, "trueStereo", trueStereoButton);
+
+    // presets are programs rather than a parameter, so the box talks to the processor directly
+    addAndMakeVisible(presetBox);
+
+    for (int i = 0; i < audioProcessor.getNumPrograms(); ++i)
+        presetBox.addItem(audioProcessor.getProgramName(i), i + 1);
+
+    presetBox.setSelectedId(audioProcessor.getCurrentProgram() + 1, juce::dontSendNotification);
+    presetBox.onChange = [this]
+    {
+        audioProcessor.setCurrentProgram(presetBox.getSelectedId() - 1);
+        audioProcessor.updateHostDisplay();
+    };
+
+    addAndMakeVisible(presetLabel);
+    presetLabel.setText("Preset", juce::dontSendNotification);
+    presetLabel.attachToComponent(&presetBox, true);
+
+    audioProcessor.getProgramChangeBroadcaster().addChangeListener(this);
 }
 
 NewProjectAudioProcessorEditor::~NewProjectAudioProcessorEditor()
 {
+    audioProcessor.getProgramChangeBroadcaster().removeChangeListener(this);
+}
+
+void NewProjectAudioProcessorEditor::changeListenerCallback (ChangeBroadcaster*)
+{
+    presetBox.setSelectedId(audioProcessor.getCurrentProgram() + 1, juce::dontSendNotification);
 }
 
 //==============================================================================
@@ -106,7 +167,11 @@ void NewProjectAudioProcessorEditor::resized()
     // This is generally where you'll want to lay out the positions of any
     // subcomponents in your editor..
     
-    auto b = getLocalBounds().removeFromRight(300);
+    auto b = getLocalBounds();
+
+    levelMeters.setBounds(b.removeFromRight(120).reduced(8));
+
+    b = b.removeFromRight(300);
 
     predelayTimeSlider.setBounds(b.removeFromTop(30));
     decaySlider.setBounds(b.removeFromTop(30));
@@ -116,4 +181,9 @@ void NewProjectAudioProcessorEditor::resized()
     bandwidthSlider.setBounds(b.removeFromTop(30));
     dampingSlider.setBounds(b.removeFromTop(30));
     mixSlider.setBounds(b.removeFromTop(30));
+    modRateSlider.setBounds(b.removeFromTop(30));
+    modDepthSlider.setBounds(b.removeFromTop(30));
+    qualityBox.setBounds(b.removeFromTop(30).reduced(0, 4));
+    trueStereoButton.setBounds(b.removeFromTop(30));
+    presetBox.setBounds(b.removeFromTop(30).reduced(0, 4));
 }
@@ -10,11 +10,13 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "LevelMeterDisplay.h"
 
 //==============================================================================
 /**
 */
 class NewProjectAudioProcessorEditor  : public juce::AudioProcessorEditor
+                                      , private ChangeListener
 {
 public:
     NewProjectAudioProcessorEditor (DattorroReverbAudioProcessor&);
@@ -61,5 +63,28 @@ private:
     std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> mixAttachment;
     juce::Label  mixLabel;
 
+    Slider modRateSlider;
+    std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> modRateAttachment;
+    juce::Label  modRateLabel;
+
+    Slider modDepthSlider;
+    std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> modDepthAttachment;
+    juce::Label  modDepthLabel;
+
+    ComboBox qualityBox;
+    std::unique_ptr<AudioProcessorValueTreeState::ComboBoxAttachment> qualityAttachment;
+    juce::Label  qualityLabel;
+
+    ToggleButton trueStereoButton { "True Stereo" };
+    std::unique_ptr<AudioProcessorValueTreeState::ButtonAttachment> trueStereoAttachment;
+
+    ComboBox presetBox;
+    juce::Label  presetLabel;
+
+    // keeps the preset box on the current program when the host changes it
+    void changeListenerCallback (ChangeBroadcaster*) override;
+
+    LevelMeterDisplay levelMeters;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NewProjectAudioProcessorEditor)
 };
@@ -22,11 +22,23 @@ DattorroReverbAudioProcessor::DattorroReverbAudioProcessor()
                        )
 #endif
 ,apvst(*this, nullptr, "ValueTree", createPararmeterLayout())
+,parameters(apvst)
+,presets(apvst)
+,state(apvst)
+,quality(apvst.getRawParameterValue ("quality"))
+,trueStereo(apvst.getRawParameterValue ("trueStereo"))
 {
+    // hosts may ask for the tail length before preparing, until then the float engine is the one to play
+    parameters.update();
+    applyReverbParameters (floatReverb.get().get());
+
+    startTimer (garbageCollectionIntervalMs);
 }
 
 DattorroReverbAudioProcessor::~DattorroReverbAudioProcessor()
 {
+    stopTimer();
+    preparationThread.removeAllJobs (true, -1);
 }
 
 //==============================================================================
@@ -64,27 +76,40 @@ bool DattorroReverbAudioProcessor::isMidiEffect() const
 
 double DattorroReverbAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailLengthSeconds.load (std::memory_order_relaxed);
 }
 
 int DattorroReverbAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return presets.size();
 }
 
 int DattorroReverbAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram.load (std::memory_order_relaxed);
 }
 
 void DattorroReverbAudioProcessor::setCurrentProgram (int index)
 {
+    if (! isPositiveAndBelow (index, presets.size()))
+        return;
+
+    currentProgram.store (index, std::memory_order_relaxed);
+
+    // the engine takes the whole preset at its next block, the host parameters follow
+    pendingPreset.store (&presets.getParameters (index), std::memory_order_release);
+    presets.applyToHost (index);
+
+    // asynchronous, so this is fine from whichever thread the host calls on
+    programChangeBroadcaster.sendChangeMessage();
 }
 
 const juce::String DattorroReverbAudioProcessor::getProgramName (int index)
 {
-    return {};
+    if (! isPositiveAndBelow (index, presets.size()))
+        return {};
+
+    return presets.getName (index);
 }
 
 void DattorroReverbAudioProcessor::changeProgramName (int index, const juce::String& newName)
@@ -97,14 +122,96 @@ void DattorroReverbAudioProcessor::prepareToPlay (double sampleRate, int samples
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 
-    plateReverb.prepareToPlay(sampleRate);
-    
+    // whatever was being prepared in the background is outdated now
+    preparationThread.removeAllJobs (true, -1);
+    floatReverb.discardPending();
+    doubleReverb.discardPending();
+
+    // the precision may have changed, so the engine to prepare gets the whole snapshot, not just what moved
+    parameters.update();
+
+    auto layout = getRequiredLayout();
+    preparedLayout.store (layout);
+
+    if (isUsingDoublePrecision())
+    {
+        applyReverbParameters (doubleReverb.get().get());
+        prepareReverb (doubleReverb.get(), sampleRate, samplesPerBlock, layout);
+    }
+    else
+    {
+        applyReverbParameters (floatReverb.get().get());
+        prepareReverb (floatReverb.get(), sampleRate, samplesPerBlock, layout);
+    }
+}
+
+template <typename ReverbType, typename SampleType>
+void DattorroReverbAudioProcessor::prepareReverb (EngineCrossfade<ReverbType, SampleType>& engines, double sampleRate, int samplesPerBlock, ReverbLayout layout)
+{
+    engines.setTransitionTime (DATTORRO_PRESET_TRANSITION_TIME);
+    engines.prepare (sampleRate, samplesPerBlock);
+
+    configureReverb (engines.get(), sampleRate, samplesPerBlock, layout);
+
+    // the spare is set up once here, preset changes only hand it parameters
+    if (auto* spare = engines.getSpare())
+        configureReverb (*spare, sampleRate, samplesPerBlock, layout);
+}
+
+template <typename ReverbType>
+void DattorroReverbAudioProcessor::configureReverb (ReverbType& reverb, double sampleRate, int samplesPerBlock, ReverbLayout layout)
+{
+    reverb.reserve (DATTORRO_RESERVED_SAMPLE_RATE, samplesPerBlock);
+    reverb.setQualityTiersEnabled (layout.qualityTiers);
+    reverb.setTrueStereoEnabled (layout.trueStereo);
+    updateQuality (reverb);
+    reverb.prepareToPlay (sampleRate, samplesPerBlock);
+}
+
+void DattorroReverbAudioProcessor::prepareReverbInBackground (double sampleRate, int samplesPerBlock)
+{
+    auto layout = getRequiredLayout();
+    preparedLayout.store (layout);
+
+    auto useDoublePrecision = isUsingDoublePrecision();
+
+    // jobs run one after the other, so the last one queued is the engine the audio thread ends up with
+    preparationThread.addJob ([this, sampleRate, samplesPerBlock, layout, useDoublePrecision]
+    {
+        // the new engine starts from the current parameter values, the audio thread hands it any later change
+        if (useDoublePrecision)
+        {
+            auto reverb = std::make_unique<EngineCrossfade<PlateReverb<double>, double>>();
+            reverb->get().setParameters (parameters.read());
+            prepareReverb (*reverb, sampleRate, samplesPerBlock, layout);
+            doubleReverb.submit (std::move (reverb));
+        }
+        else
+        {
+            auto reverb = std::make_unique<EngineCrossfade<FloatPlateReverb, float>>();
+            reverb->get().setParameters (parameters.read());
+            prepareReverb (*reverb, sampleRate, samplesPerBlock, layout);
+            floatReverb.submit (std::move (reverb));
+        }
+    });
 }
 
 void DattorroReverbAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+
+    preparationThread.removeAllJobs (true, -1);
+
+    floatReverb.discardPending();
+    floatReverb.collectGarbage();
+    floatReverb.get().releaseResources();
+
+    doubleReverb.discardPending();
+    doubleReverb.collectGarbage();
+    doubleReverb.get().releaseResources();
+
+    reverbSleeping.store (true, std::memory_order_relaxed);
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -134,6 +241,17 @@ bool DattorroReverbAudioProcessor::isBusesLayoutSupported (const BusesLayout& la
 #endif
 
 void DattorroReverbAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processReverb (buffer, floatReverb);
+}
+
+void DattorroReverbAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processReverb (buffer, doubleReverb);
+}
+
+template <typename SampleType, typename ReverbType>
+void DattorroReverbAudioProcessor::processReverb (AudioBuffer<SampleType>& buffer, EngineExchange<EngineCrossfade<ReverbType, SampleType>>& engine)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -155,16 +273,54 @@ void DattorroReverbAudioProcessor::processBlock (juce::AudioBuffer<float>& buffe
     // Alternatively, you can process the samples with the channels
     // interleaved by keeping the same state.
 
-    plateReverb.processBlock (buffer, buffer.getNumSamples(), totalNumOutputChannels);
+    // an engine prepared in the background takes over from this block on,
+    // with any parameter change made while it was being prepared
+    if (engine.swapIfPending())
+        engine.get().get().setParameters (parameters.getSnapshot());
+
+    auto& engines = engine.get();
+
+    // a recalled preset replaces all parameters at once instead of one host parameter at a time,
+    // and where there is a tail the engine crossfades into a second one running the preset
+    if (auto* preset = pendingPreset.exchange (nullptr, std::memory_order_acquire))
+    {
+        parameters.adopt (*preset);
+        engines.beginTransition (*preset);
+    }
+
+    // pick up parameter changes before processing, so they apply to this block
+    updateReverbParameters (engines.get());
+
+    updateQuality (engines.get());
+
+    // only measured while the editor shows the meters
+    auto metering = levelMeter.isActive();
+    engines.setMeteringEnabled (metering);
 
-    plateReverb.setPredelayTime(apvst.getParameter("predelay")->getValue());
-    plateReverb.setDecay(apvst.getParameter("decay")->getValue());
-    plateReverb.setDecayDiffusion1(apvst.getParameter("decayDif1")->getValue());
-    plateReverb.setInputDiffusion1(apvst.getParameter("inputDif1")->getValue());
-    plateReverb.setInputDiffusion2(apvst.getParameter("inputDif2")->getValue());
-    plateReverb.setBandwidth(apvst.getParameter("bandwidth")->getValue());
-    plateReverb.setDamping(apvst.getParameter("damping")->getValue());
-    plateReverb.setMix(apvst.getParameter("mix")->getValue());
+   #if DATTORRO_PARAMETER_POLL_INTERVAL > 0
+    // the engine runs on views into the host buffer, and the parameters are read again before each of them
+    for (int startSample = 0; startSample < buffer.getNumSamples(); startSample += DATTORRO_PARAMETER_POLL_INTERVAL)
+    {
+        if (startSample > 0)
+            updateReverbParameters (engines.get());
+
+        auto numSamples = jmin (DATTORRO_PARAMETER_POLL_INTERVAL, buffer.getNumSamples() - startSample);
+        AudioBuffer<SampleType> subBlock (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), startSample, numSamples);
+
+        engines.processBlock (subBlock, numSamples, totalNumOutputChannels);
+
+        if (metering)
+            levelMeter.push (engines.getLevels(), numSamples);
+    }
+   #else
+    engines.processBlock (buffer, buffer.getNumSamples(), totalNumOutputChannels);
+
+    if (metering)
+        levelMeter.push (engines.getLevels(), buffer.getNumSamples());
+   #endif
+
+    // other threads read this instead of reaching into an engine that may be swapped out
+    reverbSleeping.store (engines.isSleeping(), std::memory_order_relaxed);
 }
 
 //==============================================================================
@@ -185,9 +341,7 @@ void DattorroReverbAudioProcessor::getStateInformation (juce::MemoryBlock& destD
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
 
-    auto state = apvst.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    state.write (destData, currentProgram.load (std::memory_order_relaxed));
 }
 
 void DattorroReverbAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
@@ -195,11 +349,13 @@ void DattorroReverbAudioProcessor::setStateInformation (const void* data, int si
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
 
-    std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
+    auto program = state.read (data, sizeInBytes);
 
-    if (xmlState.get() != nullptr)
-        if (xmlState->hasTagName(apvst.state.getType()))
-            apvst.replaceState(juce::ValueTree::fromXml(*xmlState));
+    if (program >= 0)
+    {
+        currentProgram.store (jmin (program, presets.size() - 1), std::memory_order_relaxed);
+        programChangeBroadcaster.sendChangeMessage();
+    }
 }
 
 //==============================================================================
@@ -211,13 +367,87 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 }
 
 //==============================================================================
+template <typename ReverbType>
+void DattorroReverbAudioProcessor::updateReverbParameters (ReverbType& reverb)
+{
+    if (parameters.update())
+        applyReverbParameters (reverb);
+}
+
+template <typename ReverbType>
+void DattorroReverbAudioProcessor::applyReverbParameters (ReverbType& reverb)
+{
+    reverb.setParameters (parameters.getSnapshot());
+
+    // hosts poll the tail length, so it only has to follow the parameters
+    tailLengthSeconds.store (reverb.getTailLengthSeconds(), std::memory_order_relaxed);
+}
+
+template <typename ReverbType>
+void DattorroReverbAudioProcessor::updateQuality (ReverbType& reverb) noexcept
+{
+    auto choice = roundToInt (quality->load (std::memory_order_relaxed));
+
+    if (choice == 2)
+    {
+        reverb.setAutomaticQuality (DATTORRO_AUTOMATIC_QUALITY_BUDGET);
+    }
+    else
+    {
+        reverb.setAutomaticQuality (0.0f);
+        reverb.setQuality (choice == 1 ? PlateReverbQuality::eco : PlateReverbQuality::full);
+    }
+}
+
+DattorroReverbAudioProcessor::ReverbLayout DattorroReverbAudioProcessor::getRequiredLayout() const noexcept
+{
+    ReverbLayout layout;
+    layout.trueStereo = trueStereo->load (std::memory_order_relaxed) >= 0.5f;
+    layout.qualityTiers = roundToInt (quality->load (std::memory_order_relaxed)) != 0;
+
+    return layout;
+}
+
+void DattorroReverbAudioProcessor::updateReverbLayout()
+{
+    // before the first prepareToPlay, that will pick up the settings itself
+    if (getSampleRate() <= 0.0 || getBlockSize() <= 0)
+        return;
+
+    auto required = getRequiredLayout();
+    auto prepared = preparedLayout.load();
+
+    // an engine keeps its tiers when full is picked again, the next prepareToPlay drops them
+    if (required.trueStereo == prepared.trueStereo && (prepared.qualityTiers || ! required.qualityTiers))
+        return;
+
+    prepareReverbInBackground (getSampleRate(), getBlockSize());
+}
+
+void DattorroReverbAudioProcessor::timerCallback()
+{
+    updateReverbLayout();
+
+    floatReverb.collectGarbage();
+    doubleReverb.collectGarbage();
+
+    // an engine that faded out is cleared here for the next preset change, instead of in the audio callback
+    floatReverb.visitActive ([] (auto& engines) { engines.recycleSpare(); });
+    doubleReverb.visitActive ([] (auto& engines) { engines.recycleSpare(); });
+}
+
+bool DattorroReverbAudioProcessor::isReverbSleeping() const noexcept
+{
+    return reverbSleeping.load (std::memory_order_relaxed);
+}
+
 AudioProcessorValueTreeState::ParameterLayout DattorroReverbAudioProcessor::createPararmeterLayout()
 {
     AudioProcessorValueTreeState::ParameterLayout parameterLayout;
 
     parameterLayout.add(
-        std::make_unique<AudioParameterInt>
-        ("predelay", "Predelay", 0, 1000, 0)
+        std::make_unique<AudioParameterFloat>
+        ("predelay", "Predelay", NormalisableRange<float>(0.0, 1000.0), 0.0)
     );
 
     parameterLayout.add(
@@ -255,6 +485,26 @@ AudioProcessorValueTreeState::ParameterLayout DattorroReverbAudioProcessor::crea
         ("mix", "Mix", NormalisableRange<float>(0.0, 1.0), 0.5)
     );
 
+    parameterLayout.add(
+        std::make_unique<AudioParameterFloat>
+        ("modRate", "Modulation Rate", NormalisableRange<float>(0.1, 5.0), 1.0)
+    );
+
+    parameterLayout.add(
+        std::make_unique<AudioParameterFloat>
+        ("modDepth", "Modulation Depth", NormalisableRange<float>(0.0, 1.0), 0.0)
+    );
+
+    parameterLayout.add(
+        std::make_unique<AudioParameterChoice>
+        ("quality", "Quality", StringArray { "Full", "Eco", "Auto" }, 0)
+    );
+
+    parameterLayout.add(
+        std::make_unique<AudioParameterBool>
+        ("trueStereo", "True Stereo", false)
+    );
+
 
     return parameterLayout;
 }
@@ -10,6 +10,45 @@
 
 #include <JuceHeader.h>
 #include "Reverb/PlateReverb.h"
+#include "ReverbParameters.h"
+#include "PresetBank.h"
+#include "PluginState.h"
+#include "EngineExchange.h"
+#include "EngineCrossfade.h"
+#include "LevelMeter.h"
+
+// set to 1 to run the float engine's tank in double precision, the I/O and input chain stay float
+#ifndef DATTORRO_MIXED_PRECISION_TANK
+ #define DATTORRO_MIXED_PRECISION_TANK 0
+#endif
+
+// set to 1 to store the float engine's predelay and long tank delays as 16 bit floats, about 40% less memory for more CPU
+#ifndef DATTORRO_HALF_PRECISION_DELAYS
+ #define DATTORRO_HALF_PRECISION_DELAYS 0
+#endif
+
+// samples between parameter reads within a host block, so changes made while a block plays start ramping within that
+// many samples instead of at the next block. 0 reads them once per block
+#ifndef DATTORRO_PARAMETER_POLL_INTERVAL
+ #define DATTORRO_PARAMETER_POLL_INTERVAL 0
+#endif
+
+// the engines keep storage for rates up to this one, so sample rate changes below it don't allocate. 0 sizes for each rate exactly
+#ifndef DATTORRO_RESERVED_SAMPLE_RATE
+ #define DATTORRO_RESERVED_SAMPLE_RATE 192000
+#endif
+
+// share of each block's audio time the engine may spend before the automatic quality steps down
+#ifndef DATTORRO_AUTOMATIC_QUALITY_BUDGET
+ #define DATTORRO_AUTOMATIC_QUALITY_BUDGET 0.05f
+#endif
+
+// seconds a preset change crossfades from the old tail into a second engine running the new preset. the second
+// engine is prepared along with the first and reused for every change. 0 ramps presets in and leaves it out
+#ifndef DATTORRO_PRESET_TRANSITION_TIME
+ #define DATTORRO_PRESET_TRANSITION_TIME 0.3
+#endif
+
 //==============================================================================
 /**
 */
@@ -17,6 +56,7 @@ class DattorroReverbAudioProcessor  : public juce::AudioProcessor
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
+                             , private Timer
 {
 public:
     //==============================================================================
@@ -32,6 +72,10 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    // double-precision hosts get their own engine instead of converting every buffer
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -56,12 +100,95 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    //==============================================================================
+    // true while the reverb tail has died away and the tank is skipped
+    bool isReverbSleeping() const noexcept;
+
+    /*  Has a fresh engine for the given settings prepared on a background
+        thread while the current one keeps playing, and the audio thread
+        switch to it at the start of its next block. Returns right away.
+        Call from any thread but the audio thread.
+    */
+    void prepareReverbInBackground (double sampleRate, int samplesPerBlock);
+
+    // input, wet and tank levels of every block, for the editor's meters
+    LevelMeter& getLevelMeter() noexcept { return levelMeter; }
+
+    // sends a change message whenever the current program changes, from the host or a restored state
+    ChangeBroadcaster& getProgramChangeBroadcaster() noexcept { return programChangeBroadcaster; }
+
     //==============================================================================
     AudioProcessorValueTreeState apvst;
 
 private:
     //==============================================================================
-    PlateReverb plateReverb;
+   #if DATTORRO_MIXED_PRECISION_TANK
+    using FloatPlateReverb = PlateReverb<float, double, DATTORRO_HALF_PRECISION_DELAYS != 0>;
+   #else
+    using FloatPlateReverb = PlateReverb<float, float, DATTORRO_HALF_PRECISION_DELAYS != 0>;
+   #endif
+
+    // the storage an engine is laid out for, only preparing a new engine changes it
+    struct ReverbLayout
+    {
+        bool trueStereo = false;
+        bool qualityTiers = false;
+    };
+
+    // only the engines matching the host's processing precision are prepared
+    EngineExchange<EngineCrossfade<FloatPlateReverb, float>> floatReverb;
+    EngineExchange<EngineCrossfade<PlateReverb<double>, double>> doubleReverb;
+    ReverbParameters parameters;
+    PresetBank presets;
+    PluginState state;
+    std::atomic<float>* quality;
+    std::atomic<float>* trueStereo;
+    std::atomic<ReverbLayout> preparedLayout{ ReverbLayout() };
+    std::atomic<double> tailLengthSeconds{ 0.0 };
+    std::atomic<bool> reverbSleeping{ true };
+
+    // a recalled preset, picked up whole by the audio thread at the start of its next block
+    std::atomic<const PlateReverbParameters*> pendingPreset{ nullptr };
+    std::atomic<int> currentProgram{ 0 };
+    ChangeBroadcaster programChangeBroadcaster;
+    LevelMeter levelMeter;
+
+    // prepares replacement engines. declared last, so its jobs are done before anything they use goes away
+    ThreadPool preparationThread{ 1 };
+
+    // hands changed parameters to the playing reverb, the one matching the host's precision
+    template <typename ReverbType>
+    void updateReverbParameters (ReverbType& reverb);
+
+    // hands the whole snapshot to the reverb and reports its tail length from then on
+    template <typename ReverbType>
+    void applyReverbParameters (ReverbType& reverb);
+
+    // full, eco or automatic, as picked by the quality parameter
+    template <typename ReverbType>
+    void updateQuality (ReverbType& reverb) noexcept;
+
+    // what true stereo and the quality choice need. the eco tier's storage only comes with eco or auto
+    ReverbLayout getRequiredLayout() const noexcept;
+
+    // true stereo and the quality tiers change the engine's storage, so a change prepares a new engine off the audio thread
+    void updateReverbLayout();
+
+    // frees or clears what the audio thread handed back, which it can't do itself without risking a block,
+    // and picks up layout changes without the audio thread having to post them
+    void timerCallback() override;
+    static constexpr int garbageCollectionIntervalMs = 100;
+
+    template <typename SampleType, typename ReverbType>
+    void processReverb (AudioBuffer<SampleType>& buffer, EngineExchange<EngineCrossfade<ReverbType, SampleType>>& engine);
+
+    // prepares both engines of the crossfade
+    template <typename ReverbType, typename SampleType>
+    void prepareReverb (EngineCrossfade<ReverbType, SampleType>& engines, double sampleRate, int samplesPerBlock, ReverbLayout layout);
+
+    // sets an engine up for the layout and the current quality and prepares it
+    template <typename ReverbType>
+    void configureReverb (ReverbType& reverb, double sampleRate, int samplesPerBlock, ReverbLayout layout);
 
     AudioProcessorValueTreeState::ParameterLayout createPararmeterLayout();
 
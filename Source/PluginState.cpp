@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    PluginState.cpp
+
+  ==============================================================================
+*/
+
+#include "PluginState.h"
+
+// the order values are stored in. never reorder, new parameters go at the end with a new version
+const char* const PluginState::parameterIds[] =
+{
+    "predelay", "decay", "decayDif1", "inputDif1", "inputDif2", "bandwidth",
+    "damping", "mix", "modRate", "modDepth", "quality", "trueStereo"
+};
+
+const int PluginState::numParameters = (int) std::size (PluginState::parameterIds);
+
+PluginState::PluginState (AudioProcessorValueTreeState& apvstToUse)
+    : apvst (apvstToUse)
+{
+    for (auto* id : parameterIds)
+    {
+        parameters.push_back (apvst.getParameter (id));
+        jassert (parameters.back() != nullptr);
+    }
+}
+
+void PluginState::write (MemoryBlock& destination, int currentProgram) const
+{
+    destination.setSize ((size_t) (headerSize + numParameters * (int) sizeof (float)));
+    MemoryOutputStream stream (destination, false);
+
+    stream.writeInt (magicNumber);
+    stream.writeInt (version);
+    stream.writeInt (currentProgram);
+    stream.writeInt (numParameters);
+
+    for (auto* parameter : parameters)
+        stream.writeFloat (parameter->convertFrom0to1 (parameter->getValue()));
+}
+
+int PluginState::read (const void* data, int sizeInBytes)
+{
+    if (data == nullptr || sizeInBytes < headerSize)
+        return readXml (data, sizeInBytes);
+
+    MemoryInputStream stream (data, (size_t) sizeInBytes, false);
+
+    if (stream.readInt() != magicNumber)
+        return readXml (data, sizeInBytes);
+
+    auto storedVersion = stream.readInt();
+    auto currentProgram = stream.readInt();
+    auto numValues = stream.readInt();
+
+    if (storedVersion < 1 || numValues < 0 || numValues > (sizeInBytes - headerSize) / (int) sizeof (float))
+        return -1;
+
+    // a restore isn't an edit, so instead of setting each parameter as if it were automated
+    // the values go into the state tree, the way replaceState() puts them there
+    static const Identifier idProperty ("id");
+    static const Identifier valueProperty ("value");
+
+    for (int i = 0; i < numParameters; ++i)
+    {
+        auto* parameter = parameters[(size_t) i];
+
+        // plain values survive a range change, and an older state lacks the newer parameters
+        auto value = i < numValues ? stream.readFloat() : std::numeric_limits<float>::quiet_NaN();
+
+        if (! std::isfinite (value))
+            value = parameter->convertFrom0to1 (parameter->getDefaultValue());
+
+        auto parameterState = apvst.state.getChildWithProperty (idProperty, parameterIds[i]);
+        jassert (parameterState.isValid());
+
+        parameterState.setProperty (valueProperty, parameter->getNormalisableRange().snapToLegalValue (value), nullptr);
+    }
+
+    return jmax (0, currentProgram);
+}
+
+int PluginState::readXml (const void* data, int sizeInBytes)
+{
+    std::unique_ptr<XmlElement> xmlState (AudioProcessor::getXmlFromBinary (data, sizeInBytes));
+
+    if (xmlState == nullptr || ! xmlState->hasTagName (apvst.state.getType()))
+        return -1;
+
+    apvst.replaceState (ValueTree::fromXml (*xmlState));
+    return 0;
+}
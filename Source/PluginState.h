@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    PluginState.h
+
+    Writes the plugin state as a few bytes of plain parameter values instead
+    of XML, so hosts restoring many instances skip parsing and replaceState.
+    States saved as XML by earlier versions are still read.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class PluginState
+{
+public:
+    explicit PluginState (AudioProcessorValueTreeState& apvst);
+
+    /*  Layout, all little endian: the magic number, the format version, the
+        current program, the number of values, then each parameter's plain
+        value as a float in parameterIds order. Later versions only append
+        parameters, so any version reads the ones it knows.
+    */
+    void write (MemoryBlock& destination, int currentProgram) const;
+
+    /*  Restores the parameters from either format. Parameters missing from
+        an older state go back to their defaults. Returns the stored program,
+        0 for XML states, or -1 if the data was neither.
+    */
+    int read (const void* data, int sizeInBytes);
+
+    static constexpr int version = 1;
+
+private:
+    static constexpr int magicNumber = 0x53525044;   // "DPRS"
+    static constexpr int headerSize = 4 * (int) sizeof (int32);
+
+    static const char* const parameterIds[];
+    static const int numParameters;
+
+    AudioProcessorValueTreeState& apvst;
+    std::vector<RangedAudioParameter*> parameters;
+
+    int readXml (const void* data, int sizeInBytes);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginState)
+};
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+const char* const PresetBank::parameterIds[numValues] =
+{
+    "predelay", "decay", "decayDif1", "inputDif1", "inputDif2",
+    "bandwidth", "damping", "mix", "modRate", "modDepth"
+};
+
+float PlateReverbParameters::* const PresetBank::fields[numValues] =
+{
+    &PlateReverbParameters::predelayTime,
+    &PlateReverbParameters::decay,
+    &PlateReverbParameters::decayDiffusion1,
+    &PlateReverbParameters::inputDiffusion1,
+    &PlateReverbParameters::inputDiffusion2,
+    &PlateReverbParameters::bandwidth,
+    &PlateReverbParameters::damping,
+    &PlateReverbParameters::mix,
+    &PlateReverbParameters::modulationRate,
+    &PlateReverbParameters::modulationDepth
+};
+
+namespace
+{
+    struct FactoryPreset
+    {
+        const char* name;
+        PlateReverbParameters parameters;
+    };
+
+    // predelay, decay, decay diffusion, input diffusion 1 and 2, bandwidth, damping, mix, modulation rate and depth.
+    // the first one matches the parameter defaults
+    const FactoryPreset factoryPresets[] =
+    {
+        { "Default",      { 0.0f,  0.5f,  0.7f, 0.75f, 0.625f, 0.9995f, 0.0005f, 0.5f,  1.0f, 0.0f } },
+        { "Small Plate",  { 5.0f,  0.35f, 0.7f, 0.75f, 0.625f, 0.9995f, 0.1f,    0.3f,  1.0f, 0.0f } },
+        { "Large Plate",  { 20.0f, 0.85f, 0.7f, 0.75f, 0.625f, 0.9995f, 0.05f,   0.35f, 0.8f, 0.3f } },
+        { "Dark Plate",   { 10.0f, 0.7f,  0.7f, 0.75f, 0.625f, 0.6f,    0.4f,    0.35f, 1.0f, 0.0f } },
+        { "Slapback",     { 80.0f, 0.25f, 0.5f, 0.6f,  0.5f,   0.9f,    0.2f,    0.25f, 1.0f, 0.0f } },
+        { "Shimmer",      { 30.0f, 0.9f,  0.6f, 0.75f, 0.625f, 0.9995f, 0.0005f, 0.4f,  2.0f, 0.8f } },
+        { "Endless",      { 0.0f,  0.99f, 0.8f, 0.75f, 0.625f, 0.9995f, 0.0005f, 1.0f,  0.5f, 0.2f } }
+    };
+}
+
+PresetBank::PresetBank (AudioProcessorValueTreeState& apvst)
+{
+    for (int i = 0; i < numValues; ++i)
+    {
+        hostParameters[(size_t) i] = apvst.getParameter (parameterIds[i]);
+        jassert (hostParameters[(size_t) i] != nullptr);
+    }
+
+    presets.reserve (std::size (factoryPresets));
+
+    for (auto& factoryPreset : factoryPresets)
+    {
+        Preset preset;
+        preset.name = factoryPreset.name;
+
+        // taken through the host parameter's range, so the engine gets exactly
+        // the values the host reports back and doesn't ramp a second time
+        for (int i = 0; i < numValues; ++i)
+        {
+            auto* parameter = hostParameters[(size_t) i];
+            auto normalised = parameter->convertTo0to1 (factoryPreset.parameters.*fields[i]);
+
+            preset.normalisedValues[(size_t) i] = normalised;
+            preset.parameters.*fields[i] = parameter->convertFrom0to1 (normalised);
+        }
+
+        presets.push_back (std::move (preset));
+    }
+}
+
+const String& PresetBank::getName (int index) const
+{
+    return presets[(size_t) jlimit (0, size() - 1, index)].name;
+}
+
+const PlateReverbParameters& PresetBank::getParameters (int index) const noexcept
+{
+    return presets[(size_t) jlimit (0, size() - 1, index)].parameters;
+}
+
+void PresetBank::applyToHost (int index) const
+{
+    auto& preset = presets[(size_t) jlimit (0, size() - 1, index)];
+
+    for (int i = 0; i < numValues; ++i)
+        hostParameters[(size_t) i]->setValueNotifyingHost (preset.normalisedValues[(size_t) i]);
+}
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+
+    The factory presets, resolved once at construction into engine
+    snapshots and normalised host values, so recalling one costs the audio
+    thread a pointer swap and the message thread ten parameter writes.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Reverb/PlateReverb.h"
+
+class PresetBank
+{
+public:
+    explicit PresetBank (AudioProcessorValueTreeState& apvst);
+
+    int size() const noexcept { return (int) presets.size(); }
+
+    const String& getName (int index) const;
+
+    /*  The preset as handed to PlateReverb::setParameters, its values snapped
+        to what the host parameters hold once the preset reaches them. The
+        reference stays valid for the bank's lifetime.
+    */
+    const PlateReverbParameters& getParameters (int index) const noexcept;
+
+    // moves the host parameters to the preset, from the message thread
+    void applyToHost (int index) const;
+
+private:
+    static constexpr int numValues = 10;
+
+    struct Preset
+    {
+        String name;
+        PlateReverbParameters parameters;
+        std::array<float, numValues> normalisedValues;
+    };
+
+    static const char* const parameterIds[numValues];
+    static float PlateReverbParameters::* const fields[numValues];
+
+    std::vector<Preset> presets;
+    std::array<RangedAudioParameter*, numValues> hostParameters;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetBank)
+};
@@ -0,0 +1,633 @@
+/*
+  ==============================================================================
+
+    BatchedPlateReverb.cpp
+
+  ==============================================================================
+*/
+
+#include "BatchedPlateReverb.h"
+
+using DelayId = DattorroTopology::DelayId;
+
+void BatchedPlateReverb::VectorDelayLine::prepareToPlay (int delayInSamples, int extraCapacity)
+{
+    jassert (delayInSamples > 0);
+
+    length = jmax (1, delayInSamples);
+    mask = nextPowerOfTwo (length + extraCapacity) - 1;
+    writeIndex = 0;
+
+    buffer.assign ((size_t) mask + 1, Vector::expand (0.0f));
+}
+
+template <typename Interpolation>
+float BatchedPlateReverb::VectorDelayLine::getLaneSample (int lane, float delayInSamples) const noexcept
+{
+    auto delayInt = (int) delayInSamples;
+    auto fraction = delayInSamples - (float) delayInt;
+
+    jassert (delayInt >= Interpolation::minimumDelay && delayInt + Interpolation::extraSamples <= mask + 1);
+
+    // the lane's samples at delayInt + 2 .. delayInt - 1, laid out the way the policy indexes a buffer
+    std::array<float, 4> window;
+
+    for (int i = 0; i < 4; ++i)
+        window[(size_t) i] = buffer[(size_t) ((writeIndex - delayInt - 2 + i) & mask)].get ((size_t) lane);
+
+    return Interpolation().read (window.data(), 3, 2, fraction);
+}
+
+void BatchedPlateReverb::VectorDelayLine::clearLane (int lane)
+{
+    for (auto& sample : buffer)
+        sample.set ((size_t) lane, 0.0f);
+}
+
+//==============================================================================
+BatchedPlateReverb::BatchedPlateReverb()
+{
+    samplesLeftOutputTaps.fill (0);
+    samplesRightOutputTaps.fill (0);
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        setDefaultParameters (lane);
+        resetLane (lane);
+    }
+
+    updateCoefficients (0);
+}
+
+void BatchedPlateReverb::prepareToPlay (double sampleRate, int newMaximumBlockSize)
+{
+    currentSampleRate = sampleRate;
+
+    // jump straight to the current targets, ramps only make sense while playing
+    for (auto& lane : lanes)
+    {
+        lane.forEachSmoother ([sampleRate] (SmoothedValue<float>& smoother) { smoother.reset (sampleRate, smoothingTimeSeconds); });
+        lane.predelay.reset (sampleRate, predelaySmoothingTimeSeconds);
+    }
+
+    for (int lane = 0; lane < numLanes; ++lane)
+        resetLane (lane);
+
+    updateCoefficients (0);
+
+    maximumBlockSize = jmax (1, newMaximumBlockSize);
+
+    inputBlock.assign ((size_t) maximumBlockSize, Vector::expand (0.0f));
+    outputLeftBlock.assign ((size_t) maximumBlockSize, Vector::expand (0.0f));
+    outputRightBlock.assign ((size_t) maximumBlockSize, Vector::expand (0.0f));
+    laneScratch.calloc (maximumBlockSize);
+
+    // same network, excursion and tap validation as PlateReverb
+    auto network = DattorroTopology::getDelayNetwork (sampleRate);
+    auto excursion = DattorroTopology::toSamples (DattorroTopology::maximumExcursionMilliseconds, sampleRate) + 1;
+
+    jassert (network.delaySamples[DelayId::decayDiffusion1L] - excursion >= ModulationInterpolation::minimumDelay
+             && network.delaySamples[DelayId::decayDiffusion1R] - excursion >= ModulationInterpolation::minimumDelay);
+
+    maximumExcursionSamples = float (excursion - 1);
+
+    // the predelay keeps a block of history behind its longest tap, the modulated lines their swing
+    for (int i = 0; i < DattorroTopology::numDelays; ++i)
+    {
+        auto extraCapacity = 0;
+
+        if (i == DelayId::predelay)
+            extraCapacity = maximumBlockSize + PredelayInterpolation::extraSamples;
+        else if (i == DelayId::decayDiffusion1L || i == DelayId::decayDiffusion1R)
+            extraCapacity = excursion + ModulationInterpolation::extraSamples;
+
+        delayLines[(size_t) i].prepareToPlay (network.delaySamples[i], extraCapacity);
+    }
+
+    bandwidthOnepole.prepareToPlay (2);
+    dampingOnepoleLeft.prepareToPlay (2);
+    dampingOnepoleRight.prepareToPlay (2);
+
+    for (int i = 0; i < DattorroTopology::numTapsPerChannel; ++i)
+    {
+        auto leftLength = delayLines[DattorroTopology::leftOutputTaps[i].delayLine].getLength();
+        auto rightLength = delayLines[DattorroTopology::rightOutputTaps[i].delayLine].getLength();
+
+        jassert (network.leftTapSamples[i] < leftLength && network.rightTapSamples[i] < rightLength);
+
+        samplesLeftOutputTaps[i] = jlimit (0, leftLength - 1, network.leftTapSamples[i]);
+        samplesRightOutputTaps[i] = jlimit (0, rightLength - 1, network.rightTapSamples[i]);
+    }
+}
+
+//==============================================================================
+int BatchedPlateReverb::addLane()
+{
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        if (! lanes[(size_t) lane].active)
+        {
+            clearLane (lane);
+            setDefaultParameters (lane);
+            resetLane (lane);
+            lanes[(size_t) lane].active = true;
+            return lane;
+        }
+    }
+
+    return -1;
+}
+
+void BatchedPlateReverb::removeLane (int lane)
+{
+    jassert (isPositiveAndBelow (lane, numLanes));
+
+    lanes[(size_t) lane].active = false;
+    clearLane (lane);
+}
+
+bool BatchedPlateReverb::isLaneActive (int lane) const
+{
+    return isPositiveAndBelow (lane, numLanes) && lanes[(size_t) lane].active;
+}
+
+int BatchedPlateReverb::getNumActiveLanes() const
+{
+    return (int) std::count_if (lanes.begin(), lanes.end(), [] (const Lane& lane) { return lane.active; });
+}
+
+void BatchedPlateReverb::setDefaultParameters (int lane)
+{
+    // same base parameters as PlateReverb
+    setParameters (lane, PlateReverbParameters());
+}
+
+void BatchedPlateReverb::resetLane (int lane)
+{
+    auto& state = lanes[(size_t) lane];
+
+    state.forEachSmoother ([] (SmoothedValue<float>& smoother) { smoother.setCurrentAndTargetValue (smoother.getTargetValue()); });
+
+    state.mixValue = state.mix.getTargetValue();
+    state.modulationDepthValue = state.modulationDepth.getTargetValue();
+    state.lfoSine = 0.0f;
+    state.lfoCosine = 1.0f;
+}
+
+void BatchedPlateReverb::clearLane (int lane)
+{
+    for (auto& delayLine : delayLines)
+        delayLine.clearLane (lane);
+
+    bandwidthOnepole.clearLane (lane);
+    dampingOnepoleLeft.clearLane (lane);
+    dampingOnepoleRight.clearLane (lane);
+}
+
+bool BatchedPlateReverb::isSmoothing() const
+{
+    // the predelay ramps per sample and doesn't need control blocks, as in PlateReverb
+    for (const auto& lane : lanes)
+    {
+        if (lane.active
+            && (lane.decay.isSmoothing()
+                || lane.decayDiffusion1.isSmoothing()
+                || lane.inputDiffusion1.isSmoothing()
+                || lane.inputDiffusion2.isSmoothing()
+                || lane.bandwidth.isSmoothing()
+                || lane.damping.isSmoothing()
+                || lane.mix.isSmoothing()
+                || lane.modulationDepth.isSmoothing()))
+            return true;
+    }
+
+    return false;
+}
+
+void BatchedPlateReverb::updateCoefficients (int numSamples)
+{
+    for (int index = 0; index < numLanes; ++index)
+    {
+        auto& lane = lanes[(size_t) index];
+        auto newDecay = lane.decay.skip (numSamples);
+
+        decay.set ((size_t) index, newDecay);
+        decayDiffusion2.set ((size_t) index, jlimit (0.25f, 0.5f, float (newDecay + 0.15)));
+        decayDiffusion1.set ((size_t) index, lane.decayDiffusion1.skip (numSamples));
+        inputDiffusion1.set ((size_t) index, lane.inputDiffusion1.skip (numSamples));
+        inputDiffusion2.set ((size_t) index, lane.inputDiffusion2.skip (numSamples));
+        bandwidth.set ((size_t) index, lane.bandwidth.skip (numSamples));
+        damping.set ((size_t) index, lane.damping.skip (numSamples));
+
+        lane.mixValue = lane.mix.skip (numSamples);
+        lane.modulationDepthValue = lane.modulationDepth.skip (numSamples);
+    }
+}
+
+//==============================================================================
+void BatchedPlateReverb::processBlock (AudioBuffer<float>* const* laneBuffers, int numSamples)
+{
+    // never prepared, there is no scratch space to run the network on
+    jassert (maximumBlockSize > 0);
+
+    if (maximumBlockSize == 0)
+        return;
+
+    // host blocks larger than announced in prepareToPlay are split up,
+    // and into control blocks while any lane's parameters are ramping
+    for (int startSample = 0; startSample < numSamples;)
+    {
+        auto blockSize = jmin (maximumBlockSize, numSamples - startSample);
+
+        if (isSmoothing())
+            blockSize = jmin (blockSize, controlRateInterval);
+
+        updateCoefficients (blockSize);
+
+        // gather the mono downmix of every lane, one register per sample
+        std::fill (inputBlock.begin(), inputBlock.begin() + blockSize, Vector::expand (0.0f));
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            auto* buffer = laneBuffers[lane];
+
+            if (buffer == nullptr || ! lanes[(size_t) lane].active)
+                continue;
+
+            auto* left = buffer->getReadPointer (0, startSample);
+            auto* right = buffer->getReadPointer (1, startSample);
+
+            for (int i = 0; i < blockSize; ++i)
+                inputBlock[(size_t) i].set ((size_t) lane, (left[i] + right[i]) * 0.5f);
+        }
+
+        processPredelay (blockSize);
+
+        // unmodulated lanes read their decay diffusers at the plain length either way
+        auto modulated = std::any_of (lanes.begin(), lanes.end(), [] (const Lane& lane) { return lane.active && lane.modulationDepthValue > 0.0f; });
+
+        if (modulated)
+            processSamples<true> (blockSize);
+        else
+            processSamples<false> (blockSize);
+
+        // scatter the wet signal back and mix it into each lane's buffer
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            auto* buffer = laneBuffers[lane];
+
+            if (buffer == nullptr || ! lanes[(size_t) lane].active)
+                continue;
+
+            auto mix = lanes[(size_t) lane].mixValue;
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                const auto& wetBlock = channel == 0 ? outputLeftBlock : outputRightBlock;
+                auto* output = buffer->getWritePointer (channel, startSample);
+
+                for (int i = 0; i < blockSize; ++i)
+                    laneScratch[i] = wetBlock[(size_t) i].get ((size_t) lane);
+
+                FloatVectorOperations::multiply (output, 1.0f - mix, blockSize);
+                FloatVectorOperations::addWithMultiply (output, laneScratch.get(), mix, blockSize);
+            }
+        }
+
+        startSample += blockSize;
+    }
+}
+
+void BatchedPlateReverb::processPredelay (int numSamples)
+{
+    auto& predelayLine = delayLines[DelayId::predelay];
+
+    // the block goes in first and the taps read behind it, so a delay of 1 is no predelay at all
+    for (int i = 0; i < numSamples; ++i)
+        predelayLine.pushSample (inputBlock[(size_t) i]);
+
+    auto samplesPerMillisecond = float (currentSampleRate / 1000.0);
+    auto maximumTap = float (predelayLine.getLength());
+
+    for (int index = 0; index < numLanes; ++index)
+    {
+        auto& predelay = lanes[(size_t) index].predelay;
+
+        if (! predelay.isSmoothing())
+        {
+            auto tap = jlimit (0.0f, maximumTap, predelay.getTargetValue() * samplesPerMillisecond);
+            auto tapInSamples = (int) tap;
+            auto fraction = tap - float (tapInSamples);
+
+            // no predelay, the lane's input already is its output
+            if (tap == 0.0f)
+                continue;
+
+            // sample i of the block was pushed numSamples - 1 - i samples before the write head
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto delayInSamples = tapInSamples + numSamples - i;
+                auto value = predelayLine.getLaneSample (index, delayInSamples);
+
+                if (fraction > 0.0f)
+                    value = value * (1.0f - fraction) + predelayLine.getLaneSample (index, delayInSamples + 1) * fraction;
+
+                inputBlock[(size_t) i].set ((size_t) index, value);
+            }
+
+            continue;
+        }
+
+        // a moving tap is interpolated sample by sample
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto tap = jlimit (0.0f, maximumTap, predelay.getNextValue() * samplesPerMillisecond);
+            inputBlock[(size_t) i].set ((size_t) index, predelayLine.getLaneSample<PredelayInterpolation> (index, tap + float (numSamples - i)));
+        }
+    }
+}
+
+template <bool modulated>
+void BatchedPlateReverb::processSamples (int numSamples)
+{
+    auto& inputDiffusion1A = delayLines[DelayId::inputDiffusion1A];
+    auto& inputDiffusion1B = delayLines[DelayId::inputDiffusion1B];
+    auto& inputDiffusion2A = delayLines[DelayId::inputDiffusion2A];
+    auto& inputDiffusion2B = delayLines[DelayId::inputDiffusion2B];
+
+    auto& delayLeft1 = delayLines[DelayId::delayLeft1];
+    auto& delayLeft2 = delayLines[DelayId::delayLeft2];
+    auto& delayRight1 = delayLines[DelayId::delayRight1];
+    auto& delayRight2 = delayLines[DelayId::delayRight2];
+
+    auto& decayDiffusion1L = delayLines[DelayId::decayDiffusion1L];
+    auto& decayDiffusion2L = delayLines[DelayId::decayDiffusion2L];
+    auto& decayDiffusion1R = delayLines[DelayId::decayDiffusion1R];
+    auto& decayDiffusion2R = delayLines[DelayId::decayDiffusion2R];
+
+    const auto one = Vector::expand (1.0f);
+    const auto bandwidthFeedback = one - bandwidth;
+    const auto dampingInput = one - damping;
+
+    auto lengthLeft = float (decayDiffusion1L.getLength());
+    auto lengthRight = float (decayDiffusion1R.getLength());
+
+    auto delayLeft = Vector::expand (lengthLeft);
+    auto delayRight = Vector::expand (lengthRight);
+    auto delayLeftIncrement = Vector::expand (0.0f);
+    auto delayRightIncrement = Vector::expand (0.0f);
+
+    for (int sampleIndex = 0; sampleIndex < numSamples; ++sampleIndex)
+    {
+        if constexpr (modulated)
+        {
+            // step each lane's LFO and ramp its modulated delay times towards where it ends up
+            if (sampleIndex % lfoUpdateInterval == 0)
+            {
+                auto segmentLength = jmin (lfoUpdateInterval, numSamples - sampleIndex);
+
+                for (int index = 0; index < numLanes; ++index)
+                {
+                    auto& lane = lanes[(size_t) index];
+
+                    // an unmodulated lane keeps its LFO where it is, as PlateReverb does
+                    if (lane.modulationDepthValue <= 0.0f)
+                    {
+                        delayLeft.set ((size_t) index, lengthLeft);
+                        delayRight.set ((size_t) index, lengthRight);
+                        delayLeftIncrement.set ((size_t) index, 0.0f);
+                        delayRightIncrement.set ((size_t) index, 0.0f);
+                        continue;
+                    }
+
+                    auto excursion = lane.modulationDepthValue * maximumExcursionSamples;
+                    auto sineStart = lane.lfoSine;
+                    auto cosineStart = lane.lfoCosine;
+
+                    advanceLfo (lane, segmentLength);
+
+                    delayLeft.set ((size_t) index, lengthLeft + excursion * sineStart);
+                    delayRight.set ((size_t) index, lengthRight + excursion * cosineStart);
+                    delayLeftIncrement.set ((size_t) index, excursion * (lane.lfoSine - sineStart) / float (segmentLength));
+                    delayRightIncrement.set ((size_t) index, excursion * (lane.lfoCosine - cosineStart) / float (segmentLength));
+                }
+            }
+        }
+
+        auto sample = inputBlock[(size_t) sampleIndex];
+
+        // input signal bandwidth control
+        sample = sample * bandwidth;
+        sample = calculateOnepole (sample, bandwidthFeedback, bandwidthOnepole);
+
+        // input diffusion
+        sample = calculateLattice (sample, inputDiffusion1, inputDiffusion1A);
+        sample = calculateLattice (sample, inputDiffusion1, inputDiffusion1B);
+        sample = calculateLattice (sample, inputDiffusion2, inputDiffusion2A);
+        sample = calculateLattice (sample, inputDiffusion2, inputDiffusion2B);
+
+        // reverb tank
+        auto reverbTankInput = sample;
+
+        // reverb tank left
+        sample = sample + (delayRight2.getOutput() * decay);
+        if constexpr (modulated)
+        {
+            sample = calculateModulatedReverseLattice (sample, decayDiffusion1, delayLeft, decayDiffusion1L);
+            delayLeft += delayLeftIncrement;
+        }
+        else
+        {
+            sample = calculateReverseLattice (sample, decayDiffusion1, decayDiffusion1L);
+        }
+
+        sample = processDelay (sample, delayLeft1);
+
+        sample = sample * dampingInput;
+        sample = calculateOnepole (sample, damping, dampingOnepoleLeft);
+
+        sample = sample * decay;
+        sample = calculateLattice (sample, decayDiffusion2, decayDiffusion2L);
+
+        sample = processDelay (sample, delayLeft2);
+        sample = sample * decay;
+
+        // reverb tank right
+        sample = sample + reverbTankInput;
+        if constexpr (modulated)
+        {
+            sample = calculateModulatedReverseLattice (sample, decayDiffusion1, delayRight, decayDiffusion1R);
+            delayRight += delayRightIncrement;
+        }
+        else
+        {
+            sample = calculateReverseLattice (sample, decayDiffusion1, decayDiffusion1R);
+        }
+
+        sample = processDelay (sample, delayRight1);
+
+        sample = sample * dampingInput;
+        sample = calculateOnepole (sample, damping, dampingOnepoleRight);
+
+        sample = sample * decay;
+        sample = calculateLattice (sample, decayDiffusion2, decayDiffusion2R);
+
+        processDelay (sample, delayRight2);
+
+        // output, the taps are read one sample behind the write head
+        auto left = Vector::expand (0.0f);
+        auto right = Vector::expand (0.0f);
+
+        for (int i = 0; i < DattorroTopology::numTapsPerChannel; ++i)
+        {
+            const auto& leftTap = DattorroTopology::leftOutputTaps[i];
+            const auto& rightTap = DattorroTopology::rightOutputTaps[i];
+
+            left += delayLines[leftTap.delayLine].getSample (samplesLeftOutputTaps[i] + 1) * leftTap.gain;
+            right += delayLines[rightTap.delayLine].getSample (samplesRightOutputTaps[i] + 1) * rightTap.gain;
+        }
+
+        outputLeftBlock[(size_t) sampleIndex] = left;
+        outputRightBlock[(size_t) sampleIndex] = right;
+    }
+}
+
+void BatchedPlateReverb::advanceLfo (Lane& lane, int numSamples)
+{
+    // rotate the quadrature pair, then pull it back onto the unit circle
+    auto angle = MathConstants<double>::twoPi * lane.modulationRate * numSamples / currentSampleRate;
+    auto rotationCos = (float) std::cos (angle);
+    auto rotationSin = (float) std::sin (angle);
+
+    auto sine = lane.lfoSine * rotationCos + lane.lfoCosine * rotationSin;
+    auto cosine = lane.lfoCosine * rotationCos - lane.lfoSine * rotationSin;
+    auto magnitude = std::sqrt (sine * sine + cosine * cosine);
+
+    lane.lfoSine = sine / magnitude;
+    lane.lfoCosine = cosine / magnitude;
+}
+
+BatchedPlateReverb::Vector BatchedPlateReverb::calculateLattice (Vector sample, Vector coefficient, VectorDelayLine& delayLine)
+{
+    auto delayOutput = delayLine.getOutput();
+    auto delayInput = sample - (delayOutput * coefficient);
+    auto output = delayInput * coefficient + delayOutput;
+    delayLine.pushSample (delayInput);
+
+    return output;
+}
+
+BatchedPlateReverb::Vector BatchedPlateReverb::calculateReverseLattice (Vector sample, Vector coefficient, VectorDelayLine& delayLine)
+{
+    auto delayOutput = delayLine.getOutput();
+    auto delayInput = sample + (delayOutput * coefficient);
+    auto output = delayOutput - (delayInput * coefficient);
+    delayLine.pushSample (delayInput);
+
+    return output;
+}
+
+BatchedPlateReverb::Vector BatchedPlateReverb::calculateModulatedReverseLattice (Vector sample, Vector coefficient, Vector delayInSamples, VectorDelayLine& delayLine)
+{
+    auto delayOutput = Vector::expand (0.0f);
+
+    for (int lane = 0; lane < numLanes; ++lane)
+        delayOutput.set ((size_t) lane, delayLine.getLaneSample<ModulationInterpolation> (lane, delayInSamples.get ((size_t) lane)));
+
+    auto delayInput = sample + (delayOutput * coefficient);
+    auto output = delayOutput - (delayInput * coefficient);
+    delayLine.pushSample (delayInput);
+
+    return output;
+}
+
+BatchedPlateReverb::Vector BatchedPlateReverb::calculateOnepole (Vector sample, Vector coefficient, VectorDelayLine& delayLine)
+{
+    auto output = delayLine.getOutput() * coefficient + sample;
+    delayLine.pushSample (output);
+
+    return output;
+}
+
+BatchedPlateReverb::Vector BatchedPlateReverb::processDelay (Vector sample, VectorDelayLine& delayLine)
+{
+    auto delayOutput = delayLine.getOutput();
+    delayLine.pushSample (sample);
+
+    return delayOutput;
+}
+
+//==============================================================================
+void BatchedPlateReverb::setParameters (int lane, const PlateReverbParameters& newParameters)
+{
+    setPredelayTime (lane, newParameters.predelayTime);
+    setDecay (lane, newParameters.decay);
+    setDecayDiffusion1 (lane, newParameters.decayDiffusion1);
+    setInputDiffusion1 (lane, newParameters.inputDiffusion1);
+    setInputDiffusion2 (lane, newParameters.inputDiffusion2);
+    setBandwidth (lane, newParameters.bandwidth);
+    setDamping (lane, newParameters.damping);
+    setMix (lane, newParameters.mix);
+    setModulationRate (lane, newParameters.modulationRate);
+    setModulationDepth (lane, newParameters.modulationDepth);
+}
+
+void BatchedPlateReverb::setPredelayTime (int lane, float newPredelayTime)
+{
+    jassert (isPositiveAndBelow (lane, numLanes));
+    lanes[(size_t) lane].predelay.setTargetValue (jlimit (0.0f, 1000.0f, newPredelayTime));
+}
+
+void BatchedPlateReverb::setDecay (int lane, float newDecay)
+{
+    jassert (isPositiveAndBelow (lane, numLanes));
+    lanes[(size_t) lane].decay.setTargetValue (jlimit (0.01f, 0.99f, newDecay));
+}
+
+void BatchedPlateReverb::setDecayDiffusion1 (int lane, float newDecayDiffusion1)
+{
+    jassert (isPositiveAndBelow (lane, numLanes));
+    lanes[(size_t) lane].decayDiffusion1.setTargetValue (jlimit (0.01f, 0.99f, newDecayDiffusion1));
+}
+
+void BatchedPlateReverb::setInputDiffusion1 (int lane, float newInputDiffusion1)
+{
+    jassert (isPositiveAndBelow (lane, numLanes));
+    lanes[(size_t) lane].inputDiffusion1.setTargetValue (jlimit (0.01f, 0.99f, newInputDiffusion1));
+}
+
+void BatchedPlateReverb::setInputDiffusion2 (int lane, float newInputDiffusion2)
+{
+    jassert (isPositiveAndBelow (lane, numLanes));
+    lanes[(size_t) lane].inputDiffusion2.setTargetValue (jlimit (0.01f, 0.99f, newInputDiffusion2));
+}
+
+void BatchedPlateReverb::setBandwidth (int lane, float newBandwidth)
+{
+    jassert (isPositiveAndBelow (lane, numLanes));
+    lanes[(size_t) lane].bandwidth.setTargetValue (jlimit (0.0000001f, 0.9999999f, newBandwidth));
+}
+
+void BatchedPlateReverb::setDamping (int lane, float newDamping)
+{
+    jassert (isPositiveAndBelow (lane, numLanes));
+    lanes[(size_t) lane].damping.setTargetValue (jlimit (0.0f, 0.9999999f, newDamping));
+}
+
+void BatchedPlateReverb::setMix (int lane, float newMix)
+{
+    jassert (isPositiveAndBelow (lane, numLanes));
+    lanes[(size_t) lane].mix.setTargetValue (jlimit (0.0f, 1.0f, newMix));
+}
+
+void BatchedPlateReverb::setModulationRate (int lane, float newModulationRate)
+{
+    jassert (isPositiveAndBelow (lane, numLanes));
+    lanes[(size_t) lane].modulationRate = jlimit (0.01f, 10.0f, newModulationRate);
+}
+
+void BatchedPlateReverb::setModulationDepth (int lane, float newModulationDepth)
+{
+    jassert (isPositiveAndBelow (lane, numLanes));
+    lanes[(size_t) lane].modulationDepth.setTargetValue (jlimit (0.0f, 1.0f, newModulationDepth));
+}
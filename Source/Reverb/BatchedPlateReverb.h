@@ -0,0 +1,230 @@
+/*
+  ==============================================================================
+
+    BatchedPlateReverb.h
+
+    Runs several independent plate reverbs in lockstep, one per SIMD lane.
+    Every delay line holds one SIMD register per sample (structure of
+    arrays), so a single pass through the network steps all instances.
+
+    Each lane matches PlateReverb<float> at the full tier with the inputs
+    summed to mono: the same parameter ramps, gliding predelay and tank
+    modulation. The Equivalence tool checks one lane against it. There is
+    no sleeping, a lane keeps running until it is removed.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "DattorroTopology.h"
+#include "PlateReverb.h"
+
+class BatchedPlateReverb
+{
+public:
+    using Vector = dsp::SIMDRegister<float>;
+
+    // 4 with SSE/NEON, 8 when compiled for AVX
+    static constexpr int numLanes = (int) Vector::SIMDNumElements;
+
+    BatchedPlateReverb();
+
+    void prepareToPlay (double sampleRate, int maximumBlockSize);
+
+    // claims a free lane with cleared state and default parameters, returns -1 if all lanes are taken
+    int addLane();
+
+    // frees a lane and clears its state, so it can be handed out again
+    void removeLane (int lane);
+
+    bool isLaneActive (int lane) const;
+
+    int getNumActiveLanes() const;
+
+    /*  Processes one stereo buffer per lane in place. laneBuffers holds
+        numLanes entries, nullptr for lanes that have nothing to render.
+        Every buffer needs at least two channels and numSamples samples.
+        prepareToPlay has to run first.
+    */
+    void processBlock (AudioBuffer<float>* const* laneBuffers, int numSamples);
+
+    // applies a whole snapshot to one lane, its coefficients ramp like PlateReverb's
+    void setParameters (int lane, const PlateReverbParameters& newParameters);
+
+    // per-lane setters, same ranges and ramps as PlateReverb
+
+    // in milliseconds, 0 .. 1000. the tap glides to a new time instead of jumping
+    void setPredelayTime (int lane, float newPredelayTime);
+
+    void setDecay (int lane, float newDecay);
+
+    void setDecayDiffusion1 (int lane, float newDecayDiffusion1);
+
+    void setInputDiffusion1 (int lane, float newInputDiffusion1);
+
+    void setInputDiffusion2 (int lane, float newInputDiffusion2);
+
+    void setBandwidth (int lane, float newBandwidth);
+
+    void setDamping (int lane, float newDamping);
+
+    void setMix (int lane, float newMix);
+
+    // LFO rate in Hz of the lane's tank modulation
+    void setModulationRate (int lane, float newModulationRate);
+
+    // 0 .. 1 of Dattorro's maximum excursion, 0 switches the lane's modulation off
+    void setModulationDepth (int lane, float newModulationDepth);
+
+private:
+    // interpolation of the modulated decay diffusers and the gliding predelay tap, as in PlateReverb
+    using ModulationInterpolation = DelayInterpolation::Cubic;
+    using PredelayInterpolation = DelayInterpolation::Linear;
+
+    // delay line holding one register per sample, wrapped with a power-of-two mask
+    class VectorDelayLine
+    {
+    public:
+        // extraCapacity keeps that many more samples around for reads behind the prepared length
+        void prepareToPlay (int delayInSamples, int extraCapacity = 0);
+
+        void pushSample (Vector sample) noexcept
+        {
+            buffer[(size_t) writeIndex] = sample;
+            writeIndex = (writeIndex + 1) & mask;
+        }
+
+        Vector getSample (int delayInSamples) const noexcept
+        {
+            jassert (delayInSamples > 0 && delayInSamples <= mask + 1);
+            return buffer[(size_t) ((writeIndex - delayInSamples) & mask)];
+        }
+
+        // one lane of getSample()
+        float getLaneSample (int lane, int delayInSamples) const noexcept
+        {
+            return getSample (delayInSamples).get ((size_t) lane);
+        }
+
+        // one lane delayInSamples behind, read with the interpolation policy like DelayLine::getSample
+        template <typename Interpolation>
+        float getLaneSample (int lane, float delayInSamples) const noexcept;
+
+        Vector getOutput() const noexcept { return getSample (length); }
+
+        int getLength() const noexcept { return length; }
+
+        void clearLane (int lane);
+
+    private:
+        std::vector<Vector> buffer;
+        int length{ 0 };
+        int mask{ 0 };
+        int writeIndex{ 0 };
+    };
+
+    // everything of a lane that isn't stepped as a register: its parameter ramps and LFO
+    struct Lane
+    {
+        SmoothedValue<float> decay;
+        SmoothedValue<float> decayDiffusion1;
+        SmoothedValue<float> inputDiffusion1;
+        SmoothedValue<float> inputDiffusion2;
+        SmoothedValue<float> bandwidth;
+        SmoothedValue<float> damping;
+        SmoothedValue<float> mix;
+        SmoothedValue<float> modulationDepth;
+
+        // in milliseconds, ramped per sample
+        SmoothedValue<float> predelay;
+
+        float modulationRate{ 1.0f };
+
+        // current values, advanced once per control block
+        float mixValue{ 0.5f };
+        float modulationDepthValue{ 0.0f };
+
+        float lfoSine{ 0.0f };
+        float lfoCosine{ 1.0f };
+
+        bool active{ false };
+
+        template <typename Function>
+        void forEachSmoother (Function&& function)
+        {
+            for (auto* smoother : { &decay, &decayDiffusion1, &inputDiffusion1, &inputDiffusion2, &bandwidth,
+                                    &damping, &mix, &modulationDepth, &predelay })
+                function (*smoother);
+        }
+    };
+
+    // same control rate and ramp times as PlateReverb, so a lane follows its parameters the same way
+    static constexpr int controlRateInterval = 32;
+    static constexpr double smoothingTimeSeconds = 0.05;
+    static constexpr double predelaySmoothingTimeSeconds = 0.2;
+    static constexpr int lfoUpdateInterval = 128;
+
+    void setDefaultParameters (int lane);
+
+    // jumps the lane's ramps to their targets
+    void resetLane (int lane);
+
+    void clearLane (int lane);
+
+    bool isSmoothing() const;
+
+    void updateCoefficients (int numSamples);
+
+    void processPredelay (int numSamples);
+
+    template <bool modulated>
+    void processSamples (int numSamples);
+
+    // rotates one lane's LFO, as PlateReverb steps its tank's
+    void advanceLfo (Lane& lane, int numSamples);
+
+    Vector calculateLattice (Vector sample, Vector coefficient, VectorDelayLine& delayLine);
+
+    Vector calculateReverseLattice (Vector sample, Vector coefficient, VectorDelayLine& delayLine);
+
+    // every lane reads at its own modulated delay time, so the read is gathered lane by lane
+    Vector calculateModulatedReverseLattice (Vector sample, Vector coefficient, Vector delayInSamples, VectorDelayLine& delayLine);
+
+    Vector calculateOnepole (Vector sample, Vector coefficient, VectorDelayLine& delayLine);
+
+    Vector processDelay (Vector sample, VectorDelayLine& delayLine);
+
+    // the lanes' coefficients of the current control block
+    Vector decay;
+    Vector decayDiffusion1;
+    Vector decayDiffusion2;
+    Vector inputDiffusion1;
+    Vector inputDiffusion2;
+    Vector bandwidth;
+    Vector damping;
+
+    std::array<Lane, numLanes> lanes;
+
+    double currentSampleRate{ 0.0 };
+    float maximumExcursionSamples{ 0.0f };
+
+    // interleaved scratch space for one block
+    std::vector<Vector> inputBlock;
+    std::vector<Vector> outputLeftBlock;
+    std::vector<Vector> outputRightBlock;
+    HeapBlock<float> laneScratch;
+    int maximumBlockSize{ 0 };
+
+    // all delay lines of the network, indexed by DattorroTopology::DelayId
+    std::array<VectorDelayLine, DattorroTopology::numDelays> delayLines;
+
+    VectorDelayLine bandwidthOnepole;
+    VectorDelayLine dampingOnepoleLeft;
+    VectorDelayLine dampingOnepoleRight;
+
+    std::array<int, DattorroTopology::numTapsPerChannel> samplesLeftOutputTaps;
+    std::array<int, DattorroTopology::numTapsPerChannel> samplesRightOutputTaps;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BatchedPlateReverb)
+};
@@ -12,35 +12,67 @@
 
 #include "DelayLine.h"
 
-void DelayLine::prepareToPlay (int maxDelayInSamples)
+template <typename SampleType, typename Interpolation, typename StorageType>
+void DelayLine<SampleType, Interpolation, StorageType>::prepareToPlay (int delayInSamples, int extraCapacity)
 {
-    buffer.resize (maxDelayInSamples);
-    buffer.fill (0.f);
+    ownedBuffer.allocate (getRequiredCapacity (delayInSamples, extraCapacity), true);
+    prepareToPlay (delayInSamples, extraCapacity, ownedBuffer.get());
 }
 
-void DelayLine::pushSample (float sample)
+template <typename SampleType, typename Interpolation, typename StorageType>
+void DelayLine<SampleType, Interpolation, StorageType>::prepareToPlay (int delayInSamples, int extraCapacity, StorageType* storage)
 {
-    buffer.getReference (writeIndex) = sample;
-    writeIndex++;
-    if (writeIndex >= buffer.size()) {
-        writeIndex -= buffer.size();
-    }
-    //writeIndex = ++writeIndex % buffer.size();
+    jassert (delayInSamples > 0 && extraCapacity >= 0 && storage != nullptr);
+
+    // lines running on external storage let go of any buffer of their own
+    if (storage != ownedBuffer.get())
+        ownedBuffer.free();
+
+    length = jmax (1, delayInSamples);
+    mask = getRequiredCapacity (length, extraCapacity) - 1;
+    writeIndex = 0;
+    buffer = storage;
+
+    clear();
 }
 
-float DelayLine::getSample(int delayInSamples)
+template <typename SampleType, typename Interpolation, typename StorageType>
+void DelayLine<SampleType, Interpolation, StorageType>::clear() noexcept
 {
-    if (delayInSamples < buffer.size())
+    if (buffer != nullptr)
     {
-        auto offset = writeIndex - delayInSamples;
+        if constexpr (isNativeStorage)
+            FloatVectorOperations::clear (buffer, mask + 1);
+        else
+            std::fill (buffer, buffer + mask + 1, StorageType());
+    }
+
+    interpolation.reset();
+}
 
-        if (offset < 0)
-            offset += buffer.size();
-            
-        return buffer.getReference (offset);
+template <typename SampleType, typename Interpolation, typename StorageType>
+void DelayLine<SampleType, Interpolation, StorageType>::releaseResources()
+{
+    ownedBuffer.free();
+    buffer = nullptr;
 
-    }
+    length = 0;
+    mask = 0;
+    writeIndex = 0;
+    interpolation.reset();
+}
+
+template class DelayLine<float, DelayInterpolation::None>;
+template class DelayLine<float, DelayInterpolation::Linear>;
+template class DelayLine<float, DelayInterpolation::Cubic>;
+template class DelayLine<float, DelayInterpolation::Allpass>;
+
+template class DelayLine<double, DelayInterpolation::None>;
+template class DelayLine<double, DelayInterpolation::Linear>;
+template class DelayLine<double, DelayInterpolation::Cubic>;
+template class DelayLine<double, DelayInterpolation::Allpass>;
 
-    jassertfalse;
-    return 0.f;
-}
\ No newline at end of file
+// reduced-precision storage for the predelay and long unmodulated lines
+template class DelayLine<float, DelayInterpolation::None, HalfFloat>;
+template class DelayLine<float, DelayInterpolation::Linear, HalfFloat>;
+template class DelayLine<double, DelayInterpolation::None, HalfFloat>;
@@ -0,0 +1,260 @@
+/*
+  ==============================================================================
+
+    HalfBandFilter.cpp
+
+  ==============================================================================
+*/
+
+#include "HalfBandFilter.h"
+
+namespace HalfBand
+{
+    namespace
+    {
+        // about 70 dB of stopband rejection at this length
+        constexpr double kaiserBeta = 7.0;
+
+        // zeroth order modified Bessel function of the first kind, as a power series
+        double besselI0 (double x)
+        {
+            double sum = 1.0;
+            double term = 1.0;
+
+            for (int k = 1; k < 32; ++k)
+            {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+            }
+
+            return sum;
+        }
+
+        std::array<double, numTaps> designCoefficients()
+        {
+            std::array<double, numTaps> coefficients{};
+
+            // tap 2 * i of the whole filter, which is an odd number of taps away from the centre
+            constexpr int length = 2 * numTaps - 1;
+            constexpr int centre = numTaps - 1;
+            double sum = 0.0;
+
+            for (int i = 0; i < numTaps; ++i)
+            {
+                auto offset = 2 * i - centre;
+                auto sinc = std::sin (MathConstants<double>::halfPi * offset) / (MathConstants<double>::pi * offset);
+                auto ratio = 2.0 * (2 * i) / (length - 1) - 1.0;
+                auto window = besselI0 (kaiserBeta * std::sqrt (1.0 - ratio * ratio)) / besselI0 (kaiserBeta);
+
+                coefficients[(size_t) i] = sinc * window;
+                sum += coefficients[(size_t) i];
+            }
+
+            // with the centre tap of 0.5 the filter passes DC at exactly unity gain
+            for (auto& coefficient : coefficients)
+                coefficient *= 0.5 / sum;
+
+            return coefficients;
+        }
+    }
+
+    const std::array<double, numTaps>& getCoefficients()
+    {
+        static const auto coefficients = designCoefficients();
+        return coefficients;
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+HalfBandDecimator<SampleType>::HalfBandDecimator()
+{
+    const auto& design = HalfBand::getCoefficients();
+
+    for (int i = 0; i < HalfBand::numTaps; ++i)
+        coefficients[(size_t) i] = SampleType (design[(size_t) i]);
+}
+
+template <typename SampleType>
+void HalfBandDecimator<SampleType>::prepare (int maximumBlockSize)
+{
+    auto required = HalfBand::numTaps + maximumBlockSize / 2 + 1;
+
+    if (required > capacity)
+    {
+        evenSamples.allocate ((size_t) required, true);
+        oddSamples.allocate ((size_t) required, true);
+        capacity = required;
+    }
+
+    reset();
+}
+
+template <typename SampleType>
+int HalfBandDecimator<SampleType>::process (const SampleType* input, int numSamples, SampleType* output) noexcept
+{
+    if (numSamples <= 0)
+        return 0;
+
+    constexpr int numTaps = HalfBand::numTaps;
+    auto* even = evenSamples.get() + numTaps;
+    auto* odd = oddSamples.get() + numTaps;
+
+    // split the block into its two phases, finishing the pair the last block left open
+    int numPairs = 0;
+    int i = 0;
+
+    if (hasPendingSample)
+    {
+        even[0] = pendingSample;
+        odd[0] = input[0];
+        numPairs = 1;
+        i = 1;
+    }
+
+    for (; i + 1 < numSamples; i += 2)
+    {
+        even[numPairs] = input[i];
+        odd[numPairs] = input[i + 1];
+        numPairs++;
+    }
+
+    hasPendingSample = i < numSamples;
+
+    if (hasPendingSample)
+        pendingSample = input[i];
+
+    jassert (numTaps + numPairs <= capacity);
+
+    // the centre tap picks one sample of the even phase, the FIR branch runs over the odd one
+    FloatVectorOperations::copyWithMultiply (output, even - (numTaps / 2 - 1), SampleType(0.5), numPairs);
+
+    for (int tap = 0; tap < numTaps; ++tap)
+        FloatVectorOperations::addWithMultiply (output, odd - tap, coefficients[(size_t) tap], numPairs);
+
+    // the newest samples become the history of the next block
+    std::copy (evenSamples.get() + numPairs, evenSamples.get() + numPairs + numTaps, evenSamples.get());
+    std::copy (oddSamples.get() + numPairs, oddSamples.get() + numPairs + numTaps, oddSamples.get());
+
+    return numPairs;
+}
+
+template <typename SampleType>
+void HalfBandDecimator<SampleType>::reset() noexcept
+{
+    if (capacity > 0)
+    {
+        FloatVectorOperations::clear (evenSamples.get(), capacity);
+        FloatVectorOperations::clear (oddSamples.get(), capacity);
+    }
+
+    pendingSample = 0;
+    hasPendingSample = false;
+}
+
+template <typename SampleType>
+void HalfBandDecimator<SampleType>::releaseResources()
+{
+    evenSamples.free();
+    oddSamples.free();
+    capacity = 0;
+
+    reset();
+}
+
+//==============================================================================
+template <typename SampleType>
+HalfBandInterpolator<SampleType>::HalfBandInterpolator()
+{
+    const auto& design = HalfBand::getCoefficients();
+
+    // zero stuffing halves the level, the branch makes up for it
+    for (int i = 0; i < HalfBand::numTaps; ++i)
+        coefficients[(size_t) i] = SampleType (2.0 * design[(size_t) i]);
+}
+
+template <typename SampleType>
+void HalfBandInterpolator<SampleType>::prepare (int maximumBlockSize)
+{
+    auto required = HalfBand::numTaps + maximumBlockSize / 2 + 1;
+
+    if (required > capacity)
+    {
+        inputSamples.allocate ((size_t) required, true);
+        evenOutputs.allocate ((size_t) required, true);
+        capacity = required;
+    }
+
+    reset();
+}
+
+template <typename SampleType>
+int HalfBandInterpolator<SampleType>::process (const SampleType* input, SampleType* output, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return 0;
+
+    constexpr int numTaps = HalfBand::numTaps;
+    auto* inputs = inputSamples.get() + numTaps;
+
+    // a block that starts on the second output of a pair has one more odd output than even ones, or as many
+    auto numInputs = (numSamples + (oddPhase ? 1 : 0)) / 2;
+    auto numEven = numSamples - numInputs;
+    auto firstEvenPair = oddPhase ? 1 : 0;
+
+    jassert (numTaps + numInputs <= capacity);
+
+    FloatVectorOperations::copy (inputs, input, numInputs);
+
+    // the even output of pair k runs the FIR branch over the inputs before k
+    auto* even = evenOutputs.get();
+    FloatVectorOperations::clear (even, numEven);
+
+    for (int tap = 0; tap < numTaps; ++tap)
+        FloatVectorOperations::addWithMultiply (even, inputs + firstEvenPair - 1 - tap, coefficients[(size_t) tap], numEven);
+
+    // the odd output of pair k is the centre tap, twice 0.5 times the input numTaps / 2 before k
+    const auto* odd = inputs - numTaps / 2;
+    auto evenOffset = oddPhase ? 1 : 0;
+    auto oddOffset = 1 - evenOffset;
+
+    for (int i = 0; i < numEven; ++i)
+        output[2 * i + evenOffset] = even[i];
+
+    for (int i = 0; i < numInputs; ++i)
+        output[2 * i + oddOffset] = odd[i];
+
+    // the newest inputs become the history of the next block
+    std::copy (inputSamples.get() + numInputs, inputSamples.get() + numInputs + numTaps, inputSamples.get());
+
+    oddPhase = ((numSamples + (oddPhase ? 1 : 0)) & 1) != 0;
+
+    return numInputs;
+}
+
+template <typename SampleType>
+void HalfBandInterpolator<SampleType>::reset() noexcept
+{
+    if (capacity > 0)
+    {
+        FloatVectorOperations::clear (inputSamples.get(), capacity);
+        FloatVectorOperations::clear (evenOutputs.get(), capacity);
+    }
+
+    oddPhase = false;
+}
+
+template <typename SampleType>
+void HalfBandInterpolator<SampleType>::releaseResources()
+{
+    inputSamples.free();
+    evenOutputs.free();
+    capacity = 0;
+
+    reset();
+}
+
+template class HalfBandDecimator<float>;
+template class HalfBandDecimator<double>;
+template class HalfBandInterpolator<float>;
+template class HalfBandInterpolator<double>;
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    HalfBandFilter.h
+
+    Polyphase half-band filters that move a signal to half the host rate
+    and back, for running part of the network at the lower rate.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+/*
+    Both directions share one linear phase FIR of 2 * numTaps - 1 taps, a
+    Kaiser windowed sinc with its cutoff at a quarter of the host rate.
+    Every other tap of a half-band filter is zero apart from the centre
+    one, which is exactly 0.5, so each half-rate sample costs one branch
+    of numTaps multiplies over one input phase and a plain delay of the
+    other. The branch runs over whole blocks, one vectorised multiply-add
+    per tap.
+*/
+namespace HalfBand
+{
+    // even, so the centre tap falls into the delay branch
+    constexpr int numTaps = 16;
+
+    // the FIR branch, newest input first, summing to 0.5
+    const std::array<double, numTaps>& getCoefficients();
+}
+
+// full rate in, half rate out: one output for every second input sample
+template <typename SampleType>
+class HalfBandDecimator
+{
+public:
+    HalfBandDecimator();
+
+    // host rate samples from the input to the decimated output
+    static constexpr int latency = HalfBand::numTaps - 1;
+
+    // sizes the scratch space for blocks of up to this many input samples, only allocates when that grew
+    void prepare (int maximumBlockSize);
+
+    // returns the number of half-rate samples written to output, numSamples / 2 rounded either way
+    int process (const SampleType* input, int numSamples, SampleType* output) noexcept;
+
+    void reset() noexcept;
+
+    // frees the scratch space, prepare() has to run again before processing
+    void releaseResources();
+
+    size_t getScratchBytes() const noexcept { return 2 * (size_t) capacity * sizeof (SampleType); }
+
+private:
+    std::array<SampleType, HalfBand::numTaps> coefficients;
+
+    // both input phases split apart, each with numTaps samples of history in front of the current block
+    HeapBlock<SampleType> evenSamples;
+    HeapBlock<SampleType> oddSamples;
+    int capacity{ 0 };
+
+    // the first sample of a pair the next block completes
+    SampleType pendingSample{ 0 };
+    bool hasPendingSample{ false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HalfBandDecimator)
+};
+
+/*  Half rate in, full rate out. Runs in step with a decimator that saw
+    the same host samples: every second output sample takes the next
+    input, so numSamples outputs consume as many inputs as the decimator
+    produced from numSamples. The even outputs only use inputs that are
+    already complete, which costs one half-rate sample of latency.
+*/
+template <typename SampleType>
+class HalfBandInterpolator
+{
+public:
+    HalfBandInterpolator();
+
+    // host rate samples the output lags behind the decimator's input, beyond the decimator's own latency
+    static constexpr int latency = HalfBand::numTaps;
+
+    // sizes the scratch space for blocks of up to this many output samples, only allocates when that grew
+    void prepare (int maximumBlockSize);
+
+    // returns the number of half-rate samples it took from input
+    int process (const SampleType* input, SampleType* output, int numSamples) noexcept;
+
+    void reset() noexcept;
+
+    // frees the scratch space, prepare() has to run again before processing
+    void releaseResources();
+
+    size_t getScratchBytes() const noexcept { return 2 * (size_t) capacity * sizeof (SampleType); }
+
+private:
+    std::array<SampleType, HalfBand::numTaps> coefficients;
+
+    // the inputs with numTaps samples of history in front, and the even outputs of a block
+    HeapBlock<SampleType> inputSamples;
+    HeapBlock<SampleType> evenOutputs;
+    int capacity{ 0 };
+
+    // the next output is the second one of its pair
+    bool oddPhase{ false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HalfBandInterpolator)
+};
@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    HalfFloat.h
+
+    IEEE 754 binary16 storage for delay lines that trade precision for
+    half the memory of float. Only a storage format: samples are converted
+    to float on every read and rounded back on every write.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+#if defined (__F16C__)
+ #include <immintrin.h>
+#endif
+
+class HalfFloat
+{
+public:
+    HalfFloat() = default;
+
+    explicit HalfFloat (float value) noexcept : bits (fromFloat (value)) {}
+
+    operator float() const noexcept { return toFloat (bits); }
+
+    // 11 significant bits, so about -66 dB of rounding noise relative to the signal
+    static constexpr int significantBits = 11;
+
+private:
+    /*  Conversions with round to nearest even, overflow to infinity and
+        gradual underflow. x86 builds with F16C and ARM64 use the hardware
+        instructions, which the compiler can also vectorise in block loops.
+        Everything else gets a branch-light software version.
+    */
+    static uint16_t fromFloat (float value) noexcept
+    {
+       #if defined (__F16C__)
+        return (uint16_t) _cvtss_sh (value, _MM_FROUND_TO_NEAREST_INT);
+       #elif defined (__aarch64__) && ! defined (_MSC_VER)
+        __fp16 half = (__fp16) value;
+        uint16_t result;
+        std::memcpy (&result, &half, sizeof (result));
+        return result;
+       #else
+        constexpr uint32_t floatInfinity = 255u << 23;
+        constexpr uint32_t halfOverflow = (127u + 16u) << 23;
+        constexpr uint32_t subnormalMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+        auto x = toBits (value);
+        auto sign = x & 0x80000000u;
+        x ^= sign;
+
+        uint32_t result;
+
+        if (x >= halfOverflow)
+        {
+            // infinity stays infinity, NaN becomes a quiet NaN
+            result = x > floatInfinity ? 0x7e00u : 0x7c00u;
+        }
+        else if (x < (113u << 23))
+        {
+            // adding the magic number shifts the significand into place and does the rounding
+            result = toBits (fromBits (x) + fromBits (subnormalMagic)) - subnormalMagic;
+        }
+        else
+        {
+            auto significandOdd = (x >> 13) & 1u;
+            x += ((15u - 127u) << 23) + 0xfffu + significandOdd;
+            result = x >> 13;
+        }
+
+        return (uint16_t) (result | (sign >> 16));
+       #endif
+    }
+
+    static float toFloat (uint16_t half) noexcept
+    {
+       #if defined (__F16C__)
+        return _cvtsh_ss (half);
+       #elif defined (__aarch64__) && ! defined (_MSC_VER)
+        __fp16 value;
+        std::memcpy (&value, &half, sizeof (value));
+        return (float) value;
+       #else
+        constexpr uint32_t shiftedExponent = 0x7c00u << 13;
+
+        uint32_t result = ((uint32_t) half & 0x7fffu) << 13;
+        auto exponent = result & shiftedExponent;
+        result += (127u - 15u) << 23;
+
+        if (exponent == shiftedExponent)
+        {
+            // infinity or NaN
+            result += (128u - 16u) << 23;
+        }
+        else if (exponent == 0)
+        {
+            // zero or subnormal, renormalised by the float unit
+            result += 1u << 23;
+            result = toBits (fromBits (result) - fromBits (113u << 23));
+        }
+
+        return fromBits (result | (((uint32_t) half & 0x8000u) << 16));
+       #endif
+    }
+
+    static uint32_t toBits (float value) noexcept
+    {
+        uint32_t result;
+        std::memcpy (&result, &value, sizeof (result));
+        return result;
+    }
+
+    static float fromBits (uint32_t bits) noexcept
+    {
+        float result;
+        std::memcpy (&result, &bits, sizeof (result));
+        return result;
+    }
+
+    uint16_t bits{ 0 };
+};
+
+static_assert (sizeof (HalfFloat) == 2, "HalfFloat has to stay a plain 16 bit value");
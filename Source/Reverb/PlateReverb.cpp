@@ -10,173 +10,1167 @@
 
 #include "PlateReverb.h"
 
-PlateReverb::PlateReverb()
+using DelayId = DattorroTopology::DelayId;
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+PlateReverb<SampleType, TankType, halfPrecisionDelays>::PlateReverb()
 {
     // set base parameters
-    predelayTime = 0.0;
     decay = 0.5;
     decayDiffusion1 = 0.7;
     decayDiffusion2 = 0.5;
     inputDiffusion1 = 0.75;
     inputDiffusion2 = 0.625;
     bandwidth = 0.9995;
-    damping = 0.0005;
     mix = 0.5;
+    modulationRate = 1.0;
+    modulationDepth = 0.0;
+    setSilenceThreshold (defaultSilenceThresholdDecibels);
+
+    decaySmoother.setCurrentAndTargetValue (decay);
+    decayDiffusion1Smoother.setCurrentAndTargetValue (decayDiffusion1);
+    inputDiffusion1Smoother.setCurrentAndTargetValue (inputDiffusion1);
+    inputDiffusion2Smoother.setCurrentAndTargetValue (inputDiffusion2);
+    bandwidthSmoother.setCurrentAndTargetValue (bandwidth);
+    dampingSmoother.setCurrentAndTargetValue (0.0005f);
+    mixSmoother.setCurrentAndTargetValue (mix);
+    modulationDepthSmoother.setCurrentAndTargetValue (modulationDepth);
+    predelaySmoother.setCurrentAndTargetValue (0.0f);
+}
 
-    // write max delay times in milliseconds to the hash map
-    delayTimesMilsec.set("predelay", 1000);
-    delayTimesMilsec.set("predelayTap", predelayTime);
-
-    delayTimesMilsec.set ("delayLeft1", 149.62534);
-    delayTimesMilsec.set ("delayLeft2", 124.99579);
-    delayTimesMilsec.set ("delayRight1", 141.69550);
-    delayTimesMilsec.set ("delayRight2", 106.28003);
-
-    delayTimesMilsec.set ("inputDiffusion1A", 4.77134);
-    delayTimesMilsec.set ("inputDiffusion1B", 3.59530);
-    delayTimesMilsec.set ("inputDiffusion2A", 12.7348);
-    delayTimesMilsec.set ("inputDiffusion2B", 9.30748);
-
-    delayTimesMilsec.set ("decayDiffusion1L", 22.57988);
-    delayTimesMilsec.set ("decayDiffusion2L", 60.48183);
-    delayTimesMilsec.set ("decayDiffusion1R", 30.50972);
-    delayTimesMilsec.set ("decayDiffusion2R", 89.24431);
-
-    // write output tap values in milliseconds to the hash map
-    delayTimesMilsec.set ("delayRight1_TapLeft1", 8.93787);
-    delayTimesMilsec.set ("delayRight1_TapLeft2", 99.92943);
-    delayTimesMilsec.set ("decayDiffusion2R_TapLeft", 64.27875);
-    delayTimesMilsec.set ("delayRight2_TapLeft", 67.06763);
-    delayTimesMilsec.set ("delayLeft1_TapLeft", 66.86603);
-    delayTimesMilsec.set ("decayDiffusion2L_TapLeft", 6.28339);
-    delayTimesMilsec.set ("delayLeft2_TapLeft", 35.81868);
-
-    delayTimesMilsec.set ("delayLeft1_TapRight1", 11.86116);
-    delayTimesMilsec.set ("delayLeft1_TapRight2", 121.87090);
-    delayTimesMilsec.set ("decayDiffusion2L_TapRight", 41.26205);
-    delayTimesMilsec.set ("delayLeft2_TapRight", 89.81553);
-    delayTimesMilsec.set ("delayRight1_TapRight", 70.93175);
-    delayTimesMilsec.set ("decayDiffusion2R_TapRight", 11.25634);
-    delayTimesMilsec.set ("delayRight2_TapRight", 4.06572);
-
-    // initialise samples values
-    samplesPredelayTap = 0;
-
-    samplesDelayRight1_TapLeft1 = 0;
-    samplesDelayRight1_TapLeft2 = 0;
-    samplesDecayDiffusion2R_TapLeft = 0;
-    samplesDelayRight2_TapLeft = 0;
-    samplesDelayLeft1_TapLeft = 0;
-    samplesDecayDiffusion2L_TapLeft = 0;
-    samplesDelayLeft2_TapLeft = 0;
-
-    samplesDelayLeft1_TapRight1 = 0;
-    samplesDelayLeft1_TapRight2 = 0;
-    samplesDecayDiffusion2L_TapRight = 0;
-    samplesDelayLeft2_TapRight = 0;
-    samplesDelayRight1_TapRight = 0;
-    samplesDecayDiffusion2R_TapRight = 0;
-    samplesDelayRight2_TapRight = 0;
-}
-
-void PlateReverb::prepareToPlay(double sampleRate)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::prepareToPlay(double sampleRate, int newMaximumBlockSize)
 {
+    currentSampleRate = sampleRate;
+
+    // jump straight to the current targets, ramps only make sense while playing
+    decaySmoother.reset (sampleRate, smoothingTimeSeconds);
+    decayDiffusion1Smoother.reset (sampleRate, smoothingTimeSeconds);
+    inputDiffusion1Smoother.reset (sampleRate, smoothingTimeSeconds);
+    inputDiffusion2Smoother.reset (sampleRate, smoothingTimeSeconds);
+    bandwidthSmoother.reset (sampleRate, smoothingTimeSeconds);
+    dampingSmoother.reset (sampleRate, smoothingTimeSeconds);
+    mixSmoother.reset (sampleRate, smoothingTimeSeconds);
+    modulationDepthSmoother.reset (sampleRate, smoothingTimeSeconds);
+    predelaySmoother.reset (sampleRate, predelaySmoothingTimeSeconds);
+    updateCoefficients (0);
+
+    maximumBlockSize = jmax (1, newMaximumBlockSize);
+
+    // storage is sized for whatever was reserved, so preparing within that never allocates
+    auto storageSampleRate = jmax (sampleRate, reservedSampleRate);
+    auto storageBlockSize = jmax (maximumBlockSize, reservedBlockSize);
+
+    // the eco tank's storage is only laid out while tiers are enabled, and the input lines
+    // are twice as long in true stereo
+    tiersPrepared = qualityTiersEnabled;
+    trueStereoPrepared = trueStereoEnabled;
+
+    // scratch space for the tank input and wet output of one block
+    blockBuffer.setSize (tiersPrepared ? (int) numBlockChannels : (int) ecoTankInputChannel, storageBlockSize, false, false, true);
+
     // convert all delay times to samples using new sample rate
-    delayTimesSamp.clear();
+    auto network = DattorroTopology::getDelayNetwork (sampleRate);
 
-    for (HashMap<String, float>::Iterator i(delayTimesMilsec); i.next();)
+    allocateDelayLines (sampleRate, maximumBlockSize, getArenaSize (storageSampleRate, storageBlockSize));
+
+    if (trueStereoPrepared && 2 * storageBlockSize > interleavedCapacity)
     {
-        delayTimesSamp.set(i.getKey(), int(i.getValue() * (sampleRate / 1000)));
+        interleavedBlock.allocate ((size_t) (2 * storageBlockSize), true);
+        interleavedCapacity = 2 * storageBlockSize;
     }
 
-    // set tap time in samples for output and predelay
-    samplesPredelayTap = delayTimesSamp["predelayTap"];
+    prepareTank (tanks[(size_t) Quality::full], sampleRate, 0);
+
+    // reading the eco taps earlier makes up for the interpolator, so a tail handed
+    // between the tiers lines up. the decimator's latency adds to the predelay instead
+    if (tiersPrepared)
+        prepareTank (tanks[(size_t) Quality::eco], sampleRate / 2.0, HalfBandInterpolator<SampleType>::latency / 2);
+
+   #if DATTORRO_PROFILE_STAGES
+    profiler.prepare();
+   #endif
+
+    bandwidthOnepole.clear();
+    interleavedBandwidthOnepole.clear();
+
+    // the longest a signal can take to pass through the input chain and once
+    // around the tank, predelay excluded since its tap can change while playing
+    networkDrainSamples = getExcursionSamples (sampleRate);
 
-    samplesDelayRight1_TapLeft1 = delayTimesSamp["delayRight1_TapLeft1"];
-    samplesDelayRight1_TapLeft2 = delayTimesSamp["delayRight1_TapLeft2"];
-    samplesDecayDiffusion2R_TapLeft = delayTimesSamp["decayDiffusion2R_TapLeft"];
-    samplesDelayRight2_TapLeft = delayTimesSamp["delayRight2_TapLeft"];
-    samplesDelayLeft1_TapLeft = delayTimesSamp["delayLeft1_TapLeft"];
-    samplesDecayDiffusion2L_TapLeft = delayTimesSamp["decayDiffusion2L_TapLeft"];
-    samplesDelayLeft2_TapLeft = delayTimesSamp["delayLeft2_TapLeft"];
+    for (int i = 0; i < DattorroTopology::numDelays; ++i)
+        if (i != DelayId::predelay)
+            networkDrainSamples += network.delaySamples[i];
 
-    samplesDelayLeft1_TapRight1 = delayTimesSamp["delayLeft1_TapRight1"];
-    samplesDelayLeft1_TapRight2 = delayTimesSamp["delayLeft1_TapRight2"];
-    samplesDecayDiffusion2L_TapRight = delayTimesSamp["decayDiffusion2L_TapRight"];
-    samplesDelayLeft2_TapRight = delayTimesSamp["delayLeft2_TapRight"];
-    samplesDelayRight1_TapRight = delayTimesSamp["delayRight1_TapRight"];
-    samplesDecayDiffusion2R_TapRight = delayTimesSamp["decayDiffusion2R_TapRight"];
-    samplesDelayRight2_TapRight = delayTimesSamp["delayRight2_TapRight"];
+    if (tiersPrepared)
+        networkDrainSamples += HalfBandDecimator<SampleType>::latency + HalfBandInterpolator<SampleType>::latency;
 
-    // initialize delay lines with correct max samples
-    predelay.prepareToPlay(delayTimesSamp["predelay"]);
+    // every line has just been zeroed, so there is nothing to process until input arrives
+    samplesBelowThreshold = 0;
+    sleeping = true;
 
-    delayLeft1.prepareToPlay(delayTimesSamp["delayLeft1"]);
-    delayLeft2.prepareToPlay(delayTimesSamp["delayLeft2"]);
-    delayRight1.prepareToPlay(delayTimesSamp["delayRight1"]);
-    delayRight2.prepareToPlay(delayTimesSamp["delayRight2"]);
+    if (tiersPrepared)
+    {
+        ecoDecimator.prepare (storageBlockSize);
+
+        if (trueStereoPrepared)
+            ecoDecimatorRight.prepare (storageBlockSize);
 
-    inputDiffusion1A.prepareToPlay(delayTimesSamp["inputDiffusion1A"]);
-    inputDiffusion1B.prepareToPlay(delayTimesSamp["inputDiffusion1B"]);
-    inputDiffusion2A.prepareToPlay(delayTimesSamp["inputDiffusion2A"]);
-    inputDiffusion2B.prepareToPlay(delayTimesSamp["inputDiffusion2B"]);
+        ecoInterpolatorLeft.prepare (storageBlockSize);
+        ecoInterpolatorRight.prepare (storageBlockSize);
+    }
 
-    decayDiffusion1L.prepareToPlay(delayTimesSamp["decayDiffusion1L"]);
-    decayDiffusion2L.prepareToPlay(delayTimesSamp["decayDiffusion2L"]);
-    decayDiffusion1R.prepareToPlay(delayTimesSamp["decayDiffusion1R"]);
-    decayDiffusion2R.prepareToPlay(delayTimesSamp["decayDiffusion2R"]);
+    // with nothing in the tanks yet, the engine starts straight at the tier it should run at
+    activeQuality = getTargetQuality();
+    fadingQuality = activeQuality;
+    currentQuality.store (activeQuality, std::memory_order_relaxed);
 
-    bandwidthOnepole.prepareToPlay(2);
-    dampingOnepoleLeft.prepareToPlay(2);
-    dampingOnepoleRight.prepareToPlay(2);
+    tierFadeSamples = jmax (1, roundToInt (tierFadeSeconds * sampleRate));
+    fadeSamplesRemaining = 0;
 
+    tierHoldSamples = roundToInt (tierHoldSeconds * sampleRate);
+    samplesSinceTierChange = 0;
+    averageLoad = 0.0;
 }
 
-void PlateReverb::processBlock(juce::AudioBuffer<float>& buffer, int numSamples, int numChannels)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::prepareTank (Tank& tank, double tankSampleRate, int tapAdvance)
 {
-    float* writeBufferL = buffer.getWritePointer (0);
-    float* writeBufferR = buffer.getWritePointer (1);
-    auto* readBufferL = buffer.getReadPointer (0);
-    auto* readBufferR = buffer.getReadPointer (1);
+    auto network = DattorroTopology::getDelayNetwork (tankSampleRate);
 
-    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++)
+    // the modulated lines swing up to the maximum excursion around their length
+    auto excursion = getExcursionSamples (tankSampleRate);
+
+    jassert (network.delaySamples[DelayId::decayDiffusion1L] - excursion >= ModulationInterpolation::minimumDelay
+             && network.delaySamples[DelayId::decayDiffusion1R] - excursion >= ModulationInterpolation::minimumDelay);
+
+    tank.sampleRate = tankSampleRate;
+    tank.maximumExcursionSamples = float (excursion - 1);
+    tank.lfoSine = 0.0f;
+    tank.lfoCosine = 1.0f;
+    tank.numBlockSamples = 0;
+
+    tank.dampingOnepoleLeft.clear();
+    tank.dampingOnepoleRight.clear();
+
+    // validate every tap once here, the per-sample reads are unchecked in release builds
+    for (int i = 0; i < DattorroTopology::numTapsPerChannel; ++i)
+    {
+        tank.samplesLeftOutputTaps[i] = clampTap (network.leftTapSamples[i] - tapAdvance,
+                                                  network.delaySamples[DattorroTopology::leftOutputTaps[i].delayLine]);
+        tank.samplesRightOutputTaps[i] = clampTap (network.rightTapSamples[i] - tapAdvance,
+                                                   network.delaySamples[DattorroTopology::rightOutputTaps[i].delayLine]);
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::reserve (double maximumSampleRate, int newReservedBlockSize)
+{
+    reservedSampleRate = jmax (0.0, maximumSampleRate);
+    reservedBlockSize = jmax (0, newReservedBlockSize);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::releaseResources()
+{
+    for (auto& delayLine : inputDelayLines)
+        delayLine.releaseResources();
+
+    predelayLine.releaseResources();
+
+    for (auto& tank : tanks)
+    {
+        for (auto& delayLine : tank.delayLines)
+            delayLine.releaseResources();
+
+        for (auto& delayLine : tank.longDelayLines)
+            delayLine.releaseResources();
+
+        tank.decayDiffusion1L.releaseResources();
+        tank.decayDiffusion1R.releaseResources();
+    }
+
+    arena.free();
+    arenaSize = 0;
+
+    ecoDecimator.releaseResources();
+    ecoDecimatorRight.releaseResources();
+    ecoInterpolatorLeft.releaseResources();
+    ecoInterpolatorRight.releaseResources();
+
+    blockBuffer.setSize (0, 0);
+    maximumBlockSize = 0;
+
+    interleavedBlock.free();
+    interleavedCapacity = 0;
+
+    samplesBelowThreshold = 0;
+    sleeping = true;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::reset()
+{
+    skipSmoothing();
+
+    if (fadeSamplesRemaining > 0)
+        finishTierFade();
+
+    clearDelayLines();
+
+    for (auto& tank : tanks)
     {
-        // get input signal and sum left + right channels
-        float sample = (readBufferL[sampleIndex] + readBufferR[sampleIndex]) * float(0.5);
+        tank.lfoSine = 0.0f;
+        tank.lfoCosine = 1.0f;
+    }
+
+    // nothing to process until input arrives, like after prepareToPlay
+    samplesBelowThreshold = 0;
+    sleeping = true;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::skipSmoothing()
+{
+    for (auto* smoother : { &decaySmoother, &decayDiffusion1Smoother, &inputDiffusion1Smoother, &inputDiffusion2Smoother,
+                            &bandwidthSmoother, &dampingSmoother, &mixSmoother, &modulationDepthSmoother, &predelaySmoother })
+        smoother->setCurrentAndTargetValue (smoother->getTargetValue());
+
+    updateCoefficients (0);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+template <typename Visitor>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::visitDelayLines (double sampleRate, int blockSize, Visitor&& visit)
+{
+    auto network = DattorroTopology::getDelayNetwork (sampleRate);
+    auto excursion = getExcursionSamples (sampleRate);
+
+    // in true stereo the input lines hold interleaved pairs
+    auto numInputLanes = trueStereoPrepared ? 2 : 1;
+
+    for (auto id : DattorroTopology::processingOrder)
+    {
+        auto delayInSamples = network.delaySamples[id];
+
+        // the predelay and lines with output taps keep a block of extra history so
+        // their taps can be read back block-wise, the predelay one more to interpolate
+        if (id == DelayId::predelay)
+            visit (predelayLine, numInputLanes * delayInSamples, numInputLanes * (blockSize + PredelayInterpolation::extraSamples));
+        else if (! DattorroTopology::isInTank (id))
+            visit (inputDelayLines[id], numInputLanes * delayInSamples, 0);
+        else
+            visitTankLine (tanks[(size_t) Quality::full], id, delayInSamples, excursion, blockSize, visit);
+    }
+
+    if (! qualityTiersEnabled)
+        return;
+
+    // a block at the host rate is at most half of one plus the odd sample at the eco tank's rate
+    auto ecoNetwork = DattorroTopology::getDelayNetwork (sampleRate / 2.0);
+    auto ecoExcursion = getExcursionSamples (sampleRate / 2.0);
+
+    for (auto id : DattorroTopology::processingOrder)
+        if (DattorroTopology::isInTank (id))
+            visitTankLine (tanks[(size_t) Quality::eco], id, ecoNetwork.delaySamples[id], ecoExcursion, blockSize / 2 + 1, visit);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+template <typename Visitor>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::visitTankLine (Tank& tank, DelayId id, int delayInSamples, int excursion, int blockSize, Visitor&& visit)
+{
+    if (id == DelayId::decayDiffusion1L)
+        visit (tank.decayDiffusion1L, delayInSamples, excursion + ModulationInterpolation::extraSamples);
+    else if (id == DelayId::decayDiffusion1R)
+        visit (tank.decayDiffusion1R, delayInSamples, excursion + ModulationInterpolation::extraSamples);
+    else if (DattorroTopology::isTankDelay (id))
+        visit (tank.longDelayLines[id], delayInSamples, DattorroTopology::hasOutputTaps (id) ? blockSize : 0);
+    else
+        visit (tank.delayLines[id], delayInSamples, DattorroTopology::hasOutputTaps (id) ? blockSize : 0);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+size_t PlateReverb<SampleType, TankType, halfPrecisionDelays>::getArenaSize (double sampleRate, int blockSize)
+{
+    size_t size = 0;
+
+    visitDelayLines (sampleRate, blockSize, [&size] (auto& delayLine, int delayInSamples, int extraCapacity)
+    {
+        size += getStorageBytes<std::remove_reference_t<decltype (delayLine)>> (delayInSamples, extraCapacity);
+    });
+
+    return size;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::allocateDelayLines (double sampleRate, int blockSize, size_t storageSize)
+{
+    // only reallocates when the storage needed grew or shrank
+    if (storageSize != arenaSize)
+    {
+        arena.allocate (storageSize + cacheLineSize, false);
+        arenaSize = storageSize;
+    }
+
+    auto address = reinterpret_cast<uintptr_t> (arena.get());
+    auto* base = reinterpret_cast<char*> ((address + cacheLineSize - 1) & ~(uintptr_t) (cacheLineSize - 1));
+    size_t offset = 0;
+
+    visitDelayLines (sampleRate, blockSize, [&] (auto& delayLine, int delayInSamples, int extraCapacity)
+    {
+        using LineType = std::remove_reference_t<decltype (delayLine)>;
+
+        delayLine.prepareToPlay (delayInSamples, extraCapacity, reinterpret_cast<typename LineType::Storage*> (base + offset));
+        offset += getStorageBytes<LineType> (delayInSamples, extraCapacity);
+    });
+
+    // every line grows with the sample rate, so a network sized for a higher one always fits
+    jassert (offset <= arenaSize);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+template <typename DelayLineType>
+size_t PlateReverb<SampleType, TankType, halfPrecisionDelays>::getStorageBytes (int delayInSamples, int extraCapacity)
+{
+    auto bytes = (size_t) DelayLineType::getRequiredCapacity (delayInSamples, extraCapacity) * sizeof (typename DelayLineType::Storage);
+
+    // every line starts on a cache line of its own
+    return (bytes + cacheLineSize - 1) & ~(cacheLineSize - 1);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+int PlateReverb<SampleType, TankType, halfPrecisionDelays>::getExcursionSamples (double sampleRate)
+{
+    // one more than the LFO swing, the modulated reads land between two samples
+    return DattorroTopology::toSamples (DattorroTopology::maximumExcursionMilliseconds, sampleRate) + 1;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+size_t PlateReverb<SampleType, TankType, halfPrecisionDelays>::getFootprintInBytes() const
+{
+    auto blockBytes = (size_t) blockBuffer.getNumChannels() * (size_t) blockBuffer.getNumSamples() * sizeof (SampleType);
+    auto arenaBytes = arenaSize > 0 ? arenaSize + cacheLineSize : 0;
+    auto interleavedBytes = (size_t) interleavedCapacity * sizeof (SampleType);
+    auto filterBytes = ecoDecimator.getScratchBytes() + ecoDecimatorRight.getScratchBytes()
+                     + ecoInterpolatorLeft.getScratchBytes() + ecoInterpolatorRight.getScratchBytes();
+
+    return sizeof (*this) + arenaBytes + blockBytes + interleavedBytes + filterBytes;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processBlock(juce::AudioBuffer<SampleType>& buffer, int numSamples, int numChannels)
+{
+    // released, or never prepared
+    jassert (maximumBlockSize > 0);
+    jassert (numChannels > 0 && numChannels <= buffer.getNumChannels());
+
+    if (maximumBlockSize == 0 || numChannels <= 0)
+        return;
+
+    auto callbackStart = cpuBudget > 0.0f ? Time::getHighResolutionTicks() : 0;
+
+    DATTORRO_PROFILE_CALLBACK (profiler, numSamples);
+
+    clearLevels();
+    processSubBlocks (buffer.getWritePointer (0), numChannels > 1 ? buffer.getWritePointer (1) : nullptr, numSamples);
+
+    if (cpuBudget > 0.0f)
+        updateAutomaticQuality (Time::getHighResolutionTicks() - callbackStart, numSamples);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processBlock (juce::AudioBuffer<SampleType>& buffer, int numSamples, int numChannels,
+                                                                           const ParameterChange* changes, int numChanges)
+{
+    jassert (maximumBlockSize > 0);
+    jassert (numChannels > 0 && numChannels <= buffer.getNumChannels());
+
+    if (maximumBlockSize == 0 || numChannels <= 0)
+        return;
+
+    auto callbackStart = cpuBudget > 0.0f ? Time::getHighResolutionTicks() : 0;
+
+    DATTORRO_PROFILE_CALLBACK (profiler, numSamples);
+
+    // a mono buffer has no right channel, processSubBlocks takes the left one as the whole input
+    auto* left = buffer.getWritePointer (0);
+    auto* right = numChannels > 1 ? buffer.getWritePointer (1) : nullptr;
+    int startSample = 0;
 
-        // predelay
-        if (predelayTime != 0)
+    clearLevels();
+
+    for (int i = 0; i < numChanges; ++i)
+    {
+        jassert (i == 0 || changes[i].sampleOffset >= changes[i - 1].sampleOffset);
+
+        auto changeSample = jlimit (startSample, numSamples, changes[i].sampleOffset);
+
+        processSubBlocks (left + startSample, right != nullptr ? right + startSample : nullptr, changeSample - startSample);
+        setParameters (changes[i].parameters);
+
+        startSample = changeSample;
+    }
+
+    processSubBlocks (left + startSample, right != nullptr ? right + startSample : nullptr, numSamples - startSample);
+
+    if (cpuBudget > 0.0f)
+        updateAutomaticQuality (Time::getHighResolutionTicks() - callbackStart, numSamples);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processSubBlocks (SampleType* writeBufferL, SampleType* writeBufferR, int numSamples)
+{
+    // without true stereo both halves of the tank are fed from the one input chain
+    auto* tankInputLeft = blockBuffer.getWritePointer (tankInputChannel);
+    auto* tankInputRight = trueStereoPrepared ? blockBuffer.getWritePointer (tankInputRightChannel) : tankInputLeft;
+    auto* outputLeft = blockBuffer.getWritePointer (outputLeftChannel);
+    auto* outputRight = blockBuffer.getWritePointer (outputRightChannel);
+
+    // host blocks larger than announced in prepareToPlay are split up,
+    // and into control blocks while any parameter is ramping
+    for (int startSample = 0; startSample < numSamples;)
+    {
+        auto blockSize = jmin (maximumBlockSize, numSamples - startSample);
+
+        if (isSmoothing())
+            blockSize = jmin (blockSize, controlRateInterval);
+
+        updateCoefficients (blockSize);
+
+        auto* blockL = writeBufferL + startSample;
+        auto* blockR = writeBufferR != nullptr ? writeBufferR + startSample : nullptr;
+
+        auto inputPeak = jmax (FloatVectorOperations::findMaximum (blockL, blockSize),
+                               -FloatVectorOperations::findMinimum (blockL, blockSize));
+
+        if (blockR != nullptr)
+            inputPeak = jmax (inputPeak,
+                              FloatVectorOperations::findMaximum (blockR, blockSize),
+                              -FloatVectorOperations::findMinimum (blockR, blockSize));
+
+        if (isSleeping())
         {
-            float samplePredelay = predelay.getSample (samplesPredelayTap);
-            predelay.pushSample (sample);
-            sample = samplePredelay;
+            // the wet signal is silent, only the dry part remains
+            if (inputPeak < silenceThreshold)
+            {
+                // the predelay line is empty, so its tap can skip ahead
+                predelaySmoother.skip (blockSize);
+
+                // and there is no tail to hand over, a tier change takes effect right away
+                if (activeQuality != getTargetQuality())
+                {
+                    activeQuality = fadingQuality = getTargetQuality();
+                    currentQuality.store (activeQuality, std::memory_order_relaxed);
+                }
+
+                if (meteringEnabled)
+                {
+                    inputLevel.add (blockL, blockSize);
+
+                    if (blockR != nullptr)
+                        inputLevel.add (blockR, blockSize);
+
+                    wetLevel.addSilence (2 * blockSize);
+                    tankLevel.addSilence (2 * blockSize);
+                }
+
+                FloatVectorOperations::multiply (blockL, SampleType(1.0) - mix, blockSize);
+
+                if (blockR != nullptr)
+                    FloatVectorOperations::multiply (blockR, SampleType(1.0) - mix, blockSize);
+
+                startSample += blockSize;
+                continue;
+            }
+
+            // the network was cleared when it fell asleep, so it picks up from silence
+            sleeping = false;
+        }
+
+        // the feed-forward input chain runs stage by stage over the whole block
+        processInputChain (blockL, blockR, tankInputLeft, tankInputRight, blockSize);
+
+        // the left output is tapped mostly from the right half of the tank and the other way round,
+        // so each channel feeds the opposite half and a source stays on its side in the tail
+        processTiers (tankInputRight, tankInputLeft, outputLeft, outputRight, blockSize);
+
+        updateSilenceTracking (inputPeak, outputLeft, outputRight, blockSize);
+
+        if (meteringEnabled)
+            measureLevels (blockL, blockR, outputLeft, outputRight, blockSize);
+
+        // dry/wet mix
+        if (blockR == nullptr)
+        {
+            // a mono output gets the mean of both sides of the tail
+            FloatVectorOperations::add (outputLeft, outputRight, blockSize);
+            FloatVectorOperations::multiply (blockL, SampleType(1.0) - mix, blockSize);
+            FloatVectorOperations::addWithMultiply (blockL, outputLeft, SampleType(0.5) * mix, blockSize);
+
+            startSample += blockSize;
+            continue;
+        }
+
+        FloatVectorOperations::multiply (blockL, SampleType(1.0) - mix, blockSize);
+        FloatVectorOperations::addWithMultiply (blockL, outputLeft, mix, blockSize);
+        FloatVectorOperations::multiply (blockR, SampleType(1.0) - mix, blockSize);
+        FloatVectorOperations::addWithMultiply (blockR, outputRight, mix, blockSize);
+
+        startSample += blockSize;
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+template <typename Type>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::LevelSum::add (const Type* samples, int numSamples) noexcept
+{
+    // half floats are summed as floats
+    using ValueType = std::conditional_t<std::is_same_v<Type, HalfFloat>, float, Type>;
+
+    // independent partial results, so the loop isn't held up by the latency of a single accumulator
+    constexpr int numLanes = 8;
+    std::array<ValueType, numLanes> squares{};
+    std::array<ValueType, numLanes> peaks{};
+
+    int i = 0;
+
+    for (; i + numLanes <= numSamples; i += numLanes)
+    {
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            auto value = ValueType (samples[i + lane]);
+            squares[(size_t) lane] += value * value;
+            peaks[(size_t) lane] = jmax (peaks[(size_t) lane], std::abs (value));
+        }
+    }
+
+    for (; i < numSamples; ++i)
+    {
+        auto value = ValueType (samples[i]);
+        squares[0] += value * value;
+        peaks[0] = jmax (peaks[0], std::abs (value));
+    }
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        sumOfSquares += (double) squares[(size_t) lane];
+        peak = jmax (peak, (double) peaks[(size_t) lane]);
+    }
+
+    numValues += numSamples;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::clearLevels() noexcept
+{
+    inputLevel.clear();
+    wetLevel.clear();
+    tankLevel.clear();
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::measureLevels (const SampleType* inputLeft, const SampleType* inputRight,
+                                                                            const SampleType* outputLeft, const SampleType* outputRight, int numSamples)
+{
+    inputLevel.add (inputLeft, numSamples);
+
+    if (inputRight != nullptr)
+        inputLevel.add (inputRight, numSamples);
+    wetLevel.add (outputLeft, numSamples);
+    wetLevel.add (outputRight, numSamples);
+
+    // what each half of the tank just fed back into the other, at the rate of the tier the output comes from
+    auto addTankBlock = [this] (const auto* samples, int runLength) { tankLevel.add (samples, runLength); };
+    auto& tank = tanks[(size_t) activeQuality];
+
+    tank.longDelayLines[DelayId::delayLeft2].visitBlock (tank.numBlockSamples, 1, addTankBlock);
+    tank.longDelayLines[DelayId::delayRight2].visitBlock (tank.numBlockSamples, 1, addTankBlock);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+PlateReverbLevels PlateReverb<SampleType, TankType, halfPrecisionDelays>::getLevels() const noexcept
+{
+    Levels levels;
+    levels.inputPeak = (float) inputLevel.peak;
+    levels.inputRms = inputLevel.getRms();
+    levels.wetPeak = (float) wetLevel.peak;
+    levels.wetRms = wetLevel.getRms();
+    levels.tankPeak = (float) tankLevel.peak;
+    levels.tankRms = tankLevel.getRms();
+
+    return levels;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::updateCoefficients (int numSamples)
+{
+    auto newDecay = decaySmoother.skip (numSamples);
+
+    decay = TankType (newDecay);
+    decayDiffusion2 = TankType (getDecayDiffusion2 (newDecay));
+    decayDiffusion1 = TankType (decayDiffusion1Smoother.skip (numSamples));
+    inputDiffusion1 = SampleType (inputDiffusion1Smoother.skip (numSamples));
+    inputDiffusion2 = SampleType (inputDiffusion2Smoother.skip (numSamples));
+    bandwidth = SampleType (bandwidthSmoother.skip (numSamples));
+    mix = SampleType (mixSmoother.skip (numSamples));
+    modulationDepth = modulationDepthSmoother.skip (numSamples);
+
+    // the damping one-pole feeds back by samples, so at half the rate its coefficient
+    // is squared to keep the same time constant
+    auto newDamping = TankType (dampingSmoother.skip (numSamples));
+    tanks[(size_t) Quality::full].damping = newDamping;
+    tanks[(size_t) Quality::eco].damping = newDamping * newDamping;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::updateSilenceTracking (SampleType inputPeak, const SampleType* outputLeft, const SampleType* outputRight, int numSamples)
+{
+    auto outputPeak = jmax (FloatVectorOperations::findMaximum (outputLeft, numSamples),
+                            -FloatVectorOperations::findMinimum (outputLeft, numSamples),
+                            FloatVectorOperations::findMaximum (outputRight, numSamples),
+                            -FloatVectorOperations::findMinimum (outputRight, numSamples));
+
+    if (jmax (inputPeak, outputPeak) >= silenceThreshold)
+    {
+        samplesBelowThreshold = 0;
+        return;
+    }
+
+    samplesBelowThreshold += numSamples;
+
+    // the predelay holds on to the input for as long as its tap, wherever it is gliding
+    auto predelayMilliseconds = jmax (predelaySmoother.getCurrentValue(), predelaySmoother.getTargetValue());
+    auto predelaySamples = (int) std::ceil (predelayMilliseconds * currentSampleRate / 1000.0) + 1;
+
+    // whatever is left in the lines is below the threshold by now. clearing them
+    // makes waking up again exact and keeps denormals out of the sleeping tank
+    if (samplesBelowThreshold >= predelaySamples + networkDrainSamples)
+    {
+        if (fadeSamplesRemaining > 0)
+            finishTierFade();
+
+        clearDelayLines();
+        sleeping = true;
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::clearDelayLines()
+{
+    for (auto& delayLine : inputDelayLines)
+        delayLine.clear();
+
+    predelayLine.clear();
+
+    for (auto& tank : tanks)
+    {
+        for (auto& delayLine : tank.delayLines)
+            delayLine.clear();
+
+        for (auto& delayLine : tank.longDelayLines)
+            delayLine.clear();
+
+        tank.decayDiffusion1L.clear();
+        tank.decayDiffusion1R.clear();
+
+        tank.dampingOnepoleLeft.clear();
+        tank.dampingOnepoleRight.clear();
+    }
+
+    bandwidthOnepole.clear();
+    interleavedBandwidthOnepole.clear();
+
+    ecoDecimator.reset();
+    ecoDecimatorRight.reset();
+    ecoInterpolatorLeft.reset();
+    ecoInterpolatorRight.reset();
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+bool PlateReverb<SampleType, TankType, halfPrecisionDelays>::isSmoothing() const
+{
+    return decaySmoother.isSmoothing()
+        || decayDiffusion1Smoother.isSmoothing()
+        || inputDiffusion1Smoother.isSmoothing()
+        || inputDiffusion2Smoother.isSmoothing()
+        || bandwidthSmoother.isSmoothing()
+        || dampingSmoother.isSmoothing()
+        || mixSmoother.isSmoothing()
+        || modulationDepthSmoother.isSmoothing();
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processPredelay (SampleType* samples, int numSamples)
+{
+    // in true stereo the line holds interleaved pairs, so one frame is two samples of it
+    auto numLanes = trueStereoPrepared ? 2 : 1;
+    auto numValues = numLanes * numSamples;
+
+    // the block goes in first and the tap reads behind it, so a delay of 1 is no predelay at all
+    predelayLine.pushBlock (samples, numValues);
+
+    auto samplesPerMillisecond = SampleType (currentSampleRate / 1000.0);
+    auto maximumTap = SampleType (predelayLine.getLength() / numLanes);
+
+    if (! predelaySmoother.isSmoothing())
+    {
+        // a static tap is one contiguous segment of the history, blended with its neighbour for the fraction
+        auto tap = jlimit (SampleType(0.0), maximumTap, SampleType (predelaySmoother.getTargetValue()) * samplesPerMillisecond);
+        auto tapInSamples = (int) tap;
+        auto fraction = tap - SampleType (tapInSamples);
+
+        // no predelay, the block already holds the output and skips a trip through reduced-precision storage
+        if (tap == SampleType(0.0))
+            return;
+
+        // whole frames back from each value, so both lanes stay on their own channel
+        predelayLine.readBlock (samples, numValues, numLanes * tapInSamples + 1);
+
+        if (fraction > SampleType(0.0))
+        {
+            FloatVectorOperations::multiply (samples, SampleType(1.0) - fraction, numValues);
+            predelayLine.addBlockWithMultiply (samples, numValues, numLanes * (tapInSamples + 1) + 1, fraction);
+        }
+
+        return;
+    }
+
+    if (numLanes == 2)
+    {
+        // the neighbour to interpolate with is a whole frame back, so the pairs are blended here
+        // instead of by the line. value lane of frame i was pushed 2 * (numSamples - i) - lane samples ago
+        const auto& history = predelayLine;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto tap = jlimit (SampleType(0.0), maximumTap, SampleType (predelaySmoother.getNextValue()) * samplesPerMillisecond);
+            auto tapInSamples = (int) tap;
+            auto fraction = tap - SampleType (tapInSamples);
+
+            for (int lane = 0; lane < 2; ++lane)
+            {
+                auto delayInSamples = 2 * (tapInSamples + numSamples - i) - lane;
+                auto value1 = history.getSample (delayInSamples);
+                auto value2 = history.getSample (delayInSamples + 2);
+
+                samples[2 * i + lane] = value1 + fraction * (value2 - value1);
+            }
+        }
+
+        return;
+    }
+
+    // a moving tap is interpolated sample by sample. sample i of the block
+    // was pushed numSamples - 1 - i samples before the write head
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto tap = jlimit (SampleType(0.0), maximumTap, SampleType (predelaySmoother.getNextValue()) * samplesPerMillisecond);
+        samples[i] = predelayLine.getSample (tap + SampleType (numSamples - i));
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processInputChain (const SampleType* inputLeft, const SampleType* inputRight,
+                                                                                SampleType* outputLeft, SampleType* outputRight, int numSamples)
+{
+    DATTORRO_PROFILE_STAGE (profiler, inputChain);
+
+    if (trueStereoPrepared)
+    {
+        processStereoInputChain (inputLeft, inputRight, outputLeft, outputRight, numSamples);
+        return;
+    }
+
+    auto* output = outputLeft;
+
+    // get input signal and sum left + right channels, a mono input is taken as it is
+    if (inputRight != nullptr)
+    {
+        FloatVectorOperations::add (output, inputLeft, inputRight, numSamples);
+        FloatVectorOperations::multiply (output, SampleType(0.5), numSamples);
+    }
+    else
+    {
+        FloatVectorOperations::copy (output, inputLeft, numSamples);
+    }
+
+    processPredelay (output, numSamples);
+
+    // input signal bandwidth control
+    FloatVectorOperations::multiply (output, bandwidth, numSamples);
+    processOnepoleBlock (output, numSamples, SampleType(1.0) - bandwidth, bandwidthOnepole);
+
+    // input diffusion
+    processLatticeBlock (output, numSamples, inputDiffusion1, inputDelayLines[DelayId::inputDiffusion1A]);
+    processLatticeBlock (output, numSamples, inputDiffusion1, inputDelayLines[DelayId::inputDiffusion1B]);
+    processLatticeBlock (output, numSamples, inputDiffusion2, inputDelayLines[DelayId::inputDiffusion2A]);
+    processLatticeBlock (output, numSamples, inputDiffusion2, inputDelayLines[DelayId::inputDiffusion2B]);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processStereoInputChain (const SampleType* inputLeft, const SampleType* inputRight,
+                                                                                      SampleType* outputLeft, SampleType* outputRight, int numSamples)
+{
+    auto* pairs = interleavedBlock.get();
+    auto numValues = 2 * numSamples;
+
+    jassert (numValues <= interleavedCapacity);
+
+    // a mono input feeds both chains
+    if (inputRight == nullptr)
+        inputRight = inputLeft;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        pairs[2 * i] = inputLeft[i];
+        pairs[2 * i + 1] = inputRight[i];
+    }
+
+    processPredelay (pairs, numSamples);
+
+    // input signal bandwidth control
+    FloatVectorOperations::multiply (pairs, bandwidth, numValues);
+    processInterleavedOnepoleBlock (pairs, numValues, SampleType(1.0) - bandwidth, interleavedBandwidthOnepole);
+
+    // input diffusion. the lines are twice as long, so every delay lands on a sample of the same channel
+    processLatticeBlock (pairs, numValues, inputDiffusion1, inputDelayLines[DelayId::inputDiffusion1A]);
+    processLatticeBlock (pairs, numValues, inputDiffusion1, inputDelayLines[DelayId::inputDiffusion1B]);
+    processLatticeBlock (pairs, numValues, inputDiffusion2, inputDelayLines[DelayId::inputDiffusion2A]);
+    processLatticeBlock (pairs, numValues, inputDiffusion2, inputDelayLines[DelayId::inputDiffusion2B]);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        outputLeft[i] = pairs[2 * i];
+        outputRight[i] = pairs[2 * i + 1];
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processTiers (const SampleType* inputLeft, const SampleType* inputRight,
+                                                                           SampleType* outputLeft, SampleType* outputRight, int numSamples)
+{
+    // tier changes start on a control block boundary, each one runs its fade to the end first
+    if (fadeSamplesRemaining == 0 && activeQuality != getTargetQuality())
+        beginTierFade (getTargetQuality());
+
+    processTier (activeQuality, inputLeft, inputRight, outputLeft, outputRight, numSamples);
+
+    if (fadeSamplesRemaining == 0)
+        return;
+
+    // both tiers play the same tail until the new one has faded in
+    auto* fadeLeft = blockBuffer.getWritePointer (fadeLeftChannel);
+    auto* fadeRight = blockBuffer.getWritePointer (fadeRightChannel);
+
+    processTier (fadingQuality, inputLeft, inputRight, fadeLeft, fadeRight, numSamples);
+
+    auto fadeStep = SampleType(1.0) / SampleType (tierFadeSamples);
+    auto fadeGain = SampleType (tierFadeSamples - fadeSamplesRemaining) * fadeStep;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        fadeGain = jmin (SampleType(1.0), fadeGain + fadeStep);
+        outputLeft[i] += (fadeLeft[i] - outputLeft[i]) * fadeGain;
+        outputRight[i] += (fadeRight[i] - outputRight[i]) * fadeGain;
+    }
+
+    fadeSamplesRemaining = jmax (0, fadeSamplesRemaining - numSamples);
+
+    if (fadeSamplesRemaining == 0)
+        finishTierFade();
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processTier (Quality quality, const SampleType* inputLeft, const SampleType* inputRight,
+                                                                          SampleType* outputLeft, SampleType* outputRight, int numSamples)
+{
+    if (quality == Quality::full)
+    {
+        processTank (tanks[(size_t) Quality::full], inputLeft, inputRight, outputLeft, outputRight, numSamples);
+        return;
+    }
+
+    // the eco tank runs on every second sample of a band-limited copy of its input,
+    // and its output taps are filled back up to the host rate
+    auto* ecoInput = blockBuffer.getWritePointer (ecoTankInputChannel);
+    auto* ecoLeft = blockBuffer.getWritePointer (ecoOutputLeftChannel);
+    auto* ecoRight = blockBuffer.getWritePointer (ecoOutputRightChannel);
+
+    auto* ecoInputRight = ecoInput;
+    auto numEcoSamples = ecoDecimator.process (inputLeft, numSamples, ecoInput);
+
+    if (trueStereoPrepared)
+    {
+        ecoInputRight = blockBuffer.getWritePointer (ecoTankInputRightChannel);
+        ecoDecimatorRight.process (inputRight, numSamples, ecoInputRight);
+    }
+
+    processTank (tanks[(size_t) Quality::eco], ecoInput, ecoInputRight, ecoLeft, ecoRight, numEcoSamples);
+
+    ecoInterpolatorLeft.process (ecoLeft, outputLeft, numSamples);
+    ecoInterpolatorRight.process (ecoRight, outputRight, numSamples);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processTank (Tank& tank, const SampleType* inputLeft, const SampleType* inputRight,
+                                                                          SampleType* outputLeft, SampleType* outputRight, int numSamples)
+{
+    // unmodulated lines skip the fractional reads and the LFO entirely
+    if (modulationDepth > 0.0f)
+        processTankSamples<true> (tank, inputLeft, inputRight, numSamples);
+    else
+        processTankSamples<false> (tank, inputLeft, inputRight, numSamples);
+
+    // output, gathered block-wise now that the whole block has been written into the tank
+    gatherOutputTaps (tank, outputLeft, outputRight, numSamples);
+
+    tank.numBlockSamples = numSamples;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+PlateReverbQuality PlateReverb<SampleType, TankType, halfPrecisionDelays>::getTargetQuality() const noexcept
+{
+    if (! tiersPrepared)
+        return Quality::full;
+
+    return cpuBudget > 0.0f ? automaticQuality : selectedQuality;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::beginTierFade (Quality newQuality)
+{
+    // the new tier picks up the tail where the current one is, instead of starting out empty
+    transferTank (tanks[(size_t) activeQuality], tanks[(size_t) newQuality]);
+
+    if (newQuality == Quality::eco)
+    {
+        ecoDecimator.reset();
+        ecoDecimatorRight.reset();
+        ecoInterpolatorLeft.reset();
+        ecoInterpolatorRight.reset();
+    }
+
+    fadingQuality = newQuality;
+    fadeSamplesRemaining = tierFadeSamples;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::finishTierFade()
+{
+    activeQuality = fadingQuality;
+    fadeSamplesRemaining = 0;
+    samplesSinceTierChange = 0;
+
+    currentQuality.store (activeQuality, std::memory_order_relaxed);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setAutomaticQuality (float newCpuBudget) noexcept
+{
+    // switching it on starts from the tier already playing
+    if (cpuBudget <= 0.0f && newCpuBudget > 0.0f)
+        automaticQuality = activeQuality;
+
+    cpuBudget = jmax (0.0f, newCpuBudget);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::updateAutomaticQuality (int64 callbackTicks, int numSamples)
+{
+    if (! tiersPrepared || numSamples <= 0)
+        return;
+
+    // the share of the block's real time it took to process, averaged over about loadAveragingSeconds of audio
+    auto load = Time::highResolutionTicksToSeconds (callbackTicks) * currentSampleRate / numSamples;
+    auto weight = jmin (1.0, numSamples / (loadAveragingSeconds * currentSampleRate));
+    averageLoad += weight * (load - averageLoad);
+
+    // a fade runs both tiers, and the average needs a while to settle on the new one
+    samplesSinceTierChange = jmin (tierHoldSamples, samplesSinceTierChange + numSamples);
+
+    if (fadeSamplesRemaining > 0 || samplesSinceTierChange < tierHoldSamples)
+        return;
+
+    auto tier = (int) automaticQuality;
+
+    if (averageLoad > cpuBudget && tier < numQualityTiers - 1)
+        tier++;
+    else if (averageLoad < cpuBudget * stepUpLoadRatio && tier > 0)
+        tier--;
+
+    if (tier != (int) automaticQuality)
+    {
+        automaticQuality = (Quality) tier;
+        samplesSinceTierChange = 0;
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::transferTank (const Tank& source, Tank& destination)
+{
+    // the tiers run at the host rate or half of it, so the history is either halved or doubled
+    auto halving = source.sampleRate > destination.sampleRate;
+
+    // nothing older than the length, the LFO swing and the interpolator's neighbours is ever read again
+    auto extraHistory = (int) destination.maximumExcursionSamples + ModulationInterpolation::extraSamples + 1;
+
+    for (auto id : DattorroTopology::processingOrder)
+    {
+        if (id == DelayId::decayDiffusion1L)
+            resampleHistory (destination.decayDiffusion1L, source.decayDiffusion1L, halving, extraHistory);
+        else if (id == DelayId::decayDiffusion1R)
+            resampleHistory (destination.decayDiffusion1R, source.decayDiffusion1R, halving, extraHistory);
+        else if (DattorroTopology::isTankDelay (id))
+            resampleHistory (destination.longDelayLines[id], source.longDelayLines[id], halving, extraHistory);
+        else if (DattorroTopology::isInTank (id))
+            resampleHistory (destination.delayLines[id], source.delayLines[id], halving, extraHistory);
+    }
+
+    // the one-poles only hold two samples, close enough to copy as they are
+    destination.dampingOnepoleLeft = source.dampingOnepoleLeft;
+    destination.dampingOnepoleRight = source.dampingOnepoleRight;
+
+    destination.lfoSine = source.lfoSine;
+    destination.lfoCosine = source.lfoCosine;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+template <typename DestinationLine, typename SourceLine>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::resampleHistory (DestinationLine& destination, const SourceLine& source,
+                                                                              bool halving, int extraHistory)
+{
+    auto lastSource = source.getCapacity() - 1;
+    auto historyLength = jmin (destination.getCapacity(), destination.getLength() + extraHistory);
+
+    // oldest first, so every sample lands at the same time ago it was at in the source
+    for (int delay = historyLength; delay > 0; --delay)
+    {
+        TankType value;
+
+        if (halving)
+        {
+            // a 1 2 1 smoothing keeps the worst of the aliasing out of the tail
+            auto centre = jlimit (2, lastSource, 2 * delay);
+
+            value = TankType(0.25) * (source.getSample (centre - 1) + source.getSample (centre + 1))
+                  + TankType(0.5) * source.getSample (centre);
         }
         else
         {
-            predelay.pushSample (sample);
+            // every other sample falls halfway between two of the source
+            auto before = jlimit (1, lastSource, delay / 2);
+
+            value = (delay & 1) != 0 ? TankType(0.5) * (source.getSample (before) + source.getSample (before + 1))
+                                     : source.getSample (before);
         }
 
-        // input signal bandwidth control
-        sample = sample * bandwidth;
-        sample = calculateOnepole (sample, float(1.0) - bandwidth, bandwidthOnepole);
+        destination.pushSample (value);
+    }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::gatherOutputTaps (Tank& tank, SampleType* outputLeft, SampleType* outputRight, int numSamples)
+{
+    DATTORRO_PROFILE_STAGE (profiler, outputTaps);
+
+    FloatVectorOperations::clear (outputLeft, numSamples);
+    FloatVectorOperations::clear (outputRight, numSamples);
 
-        // input diffusion
-        sample = calculateLattice (sample, inputDiffusion1, inputDiffusion1A);
-        sample = calculateLattice (sample, inputDiffusion1, inputDiffusion1B);
-        sample = calculateLattice (sample, inputDiffusion2, inputDiffusion2A);
-        sample = calculateLattice (sample, inputDiffusion2, inputDiffusion2B);
+    for (int i = 0; i < DattorroTopology::numTapsPerChannel; ++i)
+    {
+        const auto& leftTap = DattorroTopology::leftOutputTaps[i];
+        const auto& rightTap = DattorroTopology::rightOutputTaps[i];
 
+        addOutputTap (tank, outputLeft, numSamples, leftTap.delayLine, tank.samplesLeftOutputTaps[i], SampleType (leftTap.gain));
+        addOutputTap (tank, outputRight, numSamples, rightTap.delayLine, tank.samplesRightOutputTaps[i], SampleType (rightTap.gain));
+    }
+}
 
-        // reverb tank
-        float reverbTankInput = sample;
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::addOutputTap (Tank& tank, SampleType* output, int numSamples, DattorroTopology::DelayId id, int tapInSamples, SampleType gain)
+{
+    // the taps are read one sample behind the write head
+    if (DattorroTopology::isTankDelay (id))
+        tank.longDelayLines[id].addBlockWithMultiply (output, numSamples, tapInSamples + 1, gain);
+    else
+        tank.delayLines[id].addBlockWithMultiply (output, numSamples, tapInSamples + 1, gain);
+}
 
-        // reverb tank left  
-        sample = sample + (delayRight2.getSample(0) * decay);
-        sample = calculateReverseLattice (sample, decayDiffusion1, decayDiffusion1L);
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+template <bool modulated>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processTankSamples (Tank& tank, const SampleType* inputLeft, const SampleType* inputRight, int numSamples)
+{
+    auto& delayLeft1 = tank.longDelayLines[DelayId::delayLeft1];
+    auto& delayLeft2 = tank.longDelayLines[DelayId::delayLeft2];
+    auto& delayRight1 = tank.longDelayLines[DelayId::delayRight1];
+    auto& delayRight2 = tank.longDelayLines[DelayId::delayRight2];
+
+    auto& decayDiffusion1L = tank.decayDiffusion1L;
+    auto& decayDiffusion1R = tank.decayDiffusion1R;
+    auto& decayDiffusion2L = tank.delayLines[DelayId::decayDiffusion2L];
+    auto& decayDiffusion2R = tank.delayLines[DelayId::decayDiffusion2R];
+
+    auto& dampingOnepoleLeft = tank.dampingOnepoleLeft;
+    auto& dampingOnepoleRight = tank.dampingOnepoleRight;
+    auto damping = tank.damping;
+
+    TankType delayLeft = TankType (decayDiffusion1L.getLength());
+    TankType delayRight = TankType (decayDiffusion1R.getLength());
+    TankType delayLeftIncrement = 0.0;
+    TankType delayRightIncrement = 0.0;
+
+   #if DATTORRO_PROFILE_STAGES
+    auto tankStart = PlateReverbProfiler::getTicks();
+    PlateReverbProfiler::Ticks sampledLeftTicks = 0;
+    PlateReverbProfiler::Ticks sampledRightTicks = 0;
+    int numSampledSamples = 0;
+   #endif
+
+    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++)
+    {
+       #if DATTORRO_PROFILE_STAGES
+        // only some samples are split between the halves, see PlateReverbProfiler::addTank()
+        auto sampled = sampleIndex % PlateReverbProfiler::tankSampleInterval == 0;
+        auto halfStart = sampled ? PlateReverbProfiler::getTicks() : 0;
+       #endif
+
+        if constexpr (modulated)
+        {
+            // step the LFO and ramp both modulated delay times towards where it ends up
+            if (sampleIndex % lfoUpdateInterval == 0)
+            {
+                auto segmentLength = jmin (lfoUpdateInterval, numSamples - sampleIndex);
+                auto excursion = modulationDepth * tank.maximumExcursionSamples;
+                auto sineStart = tank.lfoSine;
+                auto cosineStart = tank.lfoCosine;
+
+                advanceLfo (tank, segmentLength);
+
+                delayLeft = TankType (decayDiffusion1L.getLength()) + TankType (excursion * sineStart);
+                delayRight = TankType (decayDiffusion1R.getLength()) + TankType (excursion * cosineStart);
+                delayLeftIncrement = TankType (excursion * (tank.lfoSine - sineStart) / float (segmentLength));
+                delayRightIncrement = TankType (excursion * (tank.lfoCosine - cosineStart) / float (segmentLength));
+            }
+        }
+
+        // reverb tank, each half fed from its own input chain in true stereo
+        TankType sample = inputLeft[sampleIndex];
+
+        // reverb tank left
+        sample = sample + (delayRight2.getOutput() * decay);
+        if constexpr (modulated)
+        {
+            sample = calculateModulatedReverseLattice (sample, decayDiffusion1, delayLeft, decayDiffusion1L);
+            delayLeft += delayLeftIncrement;
+        }
+        else
+        {
+            sample = calculateReverseLattice (sample, decayDiffusion1, decayDiffusion1L);
+        }
 
         sample = processDelay (sample, delayLeft1);
 
-        sample = sample * (float(1.0) - damping);
+        sample = sample * (TankType(1.0) - damping);
         sample = calculateOnepole (sample, damping, dampingOnepoleLeft);
 
         sample = sample * decay;
@@ -185,13 +1179,25 @@ void PlateReverb::processBlock(juce::AudioBuffer<float>& buffer, int numSamples,
         sample = processDelay (sample, delayLeft2);
         sample = sample * decay;
 
+       #if DATTORRO_PROFILE_STAGES
+        auto leftEnd = sampled ? PlateReverbProfiler::getTicks() : 0;
+       #endif
+
         // reverb tank right
-        sample = sample + reverbTankInput;
-        sample = calculateReverseLattice (sample, decayDiffusion1, decayDiffusion1R);
+        sample = sample + TankType (inputRight[sampleIndex]);
+        if constexpr (modulated)
+        {
+            sample = calculateModulatedReverseLattice (sample, decayDiffusion1, delayRight, decayDiffusion1R);
+            delayRight += delayRightIncrement;
+        }
+        else
+        {
+            sample = calculateReverseLattice (sample, decayDiffusion1, decayDiffusion1R);
+        }
 
         sample = processDelay (sample, delayRight1);
 
-        sample = sample * (float(1.0) - damping);
+        sample = sample * (TankType(1.0) - damping);
         sample = calculateOnepole (sample, damping, dampingOnepoleRight);
 
         sample = sample * decay;
@@ -199,68 +1205,194 @@ void PlateReverb::processBlock(juce::AudioBuffer<float>& buffer, int numSamples,
 
         processDelay (sample, delayRight2);
 
-        // output
-        float outputLeft;
-        outputLeft = float(0.6) * delayRight1.getSample (samplesDelayRight1_TapLeft1 + 1);
-        outputLeft += float(0.6) * delayRight1.getSample (samplesDelayRight1_TapLeft2 + 1);
-        outputLeft -= float(0.6) * decayDiffusion2R.getSample (samplesDecayDiffusion2R_TapLeft + 1);
-        outputLeft += float(0.6) * delayRight2.getSample (samplesDelayRight2_TapLeft + 1);
-        outputLeft -= float(0.6) * delayLeft1.getSample (samplesDelayLeft1_TapLeft + 1);
-        outputLeft -= float(0.6) * decayDiffusion2L.getSample (samplesDecayDiffusion2L_TapLeft + 1);
-        outputLeft -= float(0.6) * delayLeft2.getSample (samplesDelayLeft2_TapLeft + 1);
+       #if DATTORRO_PROFILE_STAGES
+        if (sampled)
+        {
+            sampledLeftTicks += leftEnd - halfStart;
+            sampledRightTicks += PlateReverbProfiler::getTicks() - leftEnd;
+            numSampledSamples++;
+        }
+       #endif
+    }
+
+   #if DATTORRO_PROFILE_STAGES
+    profiler.addTank (tankStart, PlateReverbProfiler::getTicks(), sampledLeftTicks, sampledRightTicks, numSampledSamples);
+   #endif
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::advanceLfo (Tank& tank, int numSamples)
+{
+    // rotate the quadrature pair, then pull it back onto the unit circle
+    auto angle = MathConstants<double>::twoPi * modulationRate * numSamples / tank.sampleRate;
+    auto rotationCos = (float) std::cos (angle);
+    auto rotationSin = (float) std::sin (angle);
+
+    auto sine = tank.lfoSine * rotationCos + tank.lfoCosine * rotationSin;
+    auto cosine = tank.lfoCosine * rotationCos - tank.lfoSine * rotationSin;
+    auto magnitude = std::sqrt (sine * sine + cosine * cosine);
+
+    tank.lfoSine = sine / magnitude;
+    tank.lfoCosine = cosine / magnitude;
+}
 
-        float outputRight;
-        outputRight = float(0.6) * delayLeft1.getSample (samplesDelayLeft1_TapRight1 + 1);
-        outputRight += float(0.6) * delayLeft1.getSample (samplesDelayLeft1_TapRight2 + 1);
-        outputRight -= float(0.6) * decayDiffusion2L.getSample (samplesDecayDiffusion2L_TapRight + 1);
-        outputRight += float(0.6) * delayLeft2.getSample (samplesDelayLeft2_TapRight + 1);
-        outputRight -= float(0.6) * delayRight1.getSample (samplesDelayRight1_TapRight + 1);
-        outputRight -= float(0.6) * decayDiffusion2R.getSample (samplesDecayDiffusion2R_TapRight + 1);
-        outputRight -= float(0.6) * delayRight2.getSample (samplesDelayRight2_TapRight + 1);
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processLatticeBlock (SampleType* samples, int numSamples, SampleType coefficient, InputDelayLine& delayLine)
+{
+    delayLine.processBlock (samples, numSamples, delayLine.getLength(),
+                            [coefficient] (SampleType sample, SampleType delayOutput, SampleType& delayInput)
+                            {
+                                delayInput = sample - (delayOutput * coefficient);
+                                return delayInput * coefficient + delayOutput;
+                            });
+}
 
-        writeBufferL[sampleIndex] = (readBufferL[sampleIndex] * (1.0 - mix)) + (outputLeft * mix);
-        writeBufferR[sampleIndex] = (readBufferR[sampleIndex] * (1.0 - mix)) + (outputRight * mix);
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processOnepoleBlock (SampleType* samples, int numSamples, SampleType coefficient, OnepoleState<SampleType>& state)
+{
+    // recursive, so this one can't be vectorised
+    for (int i = 0; i < numSamples; ++i)
+    {
+        SampleType output = state.getOutput() * coefficient + samples[i];
+        state.pushSample (output);
+        samples[i] = output;
     }
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::processInterleavedOnepoleBlock (SampleType* samples, int numSamples, SampleType coefficient,
+                                                                                             InterleavedOnepoleState& state)
+{
+    auto& history = state.history;
+    auto numFromHistory = jmin (4, numSamples);
+
+    // the first four feed back from the last block, the rest from four samples earlier in this one
+    for (int i = 0; i < numFromHistory; ++i)
+        samples[i] = history[(size_t) i] * coefficient + samples[i];
+
+    for (int i = 4; i < numSamples; ++i)
+        samples[i] = samples[i - 4] * coefficient + samples[i];
+
+    // a block shorter than the history keeps the newer part of the old one
+    if (numSamples < 4)
+        std::copy (history.begin() + numSamples, history.end(), history.begin());
+
+    std::copy (samples + numSamples - numFromHistory, samples + numSamples, history.end() - numFromHistory);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+TankType PlateReverb<SampleType, TankType, halfPrecisionDelays>::calculateLattice (TankType sample, TankType coefficient, TankDelayLine& delayLine)
+{
+    TankType delayOutput = delayLine.getOutput();
+    TankType delayInput = sample - (delayOutput * coefficient);
+    TankType output = delayInput * coefficient + delayOutput;
+    delayLine.pushSample (delayInput);
 
+    return output;
 }
 
-float PlateReverb::calculateLattice (float sample, float coefficient, DelayLine& delayLine)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+template <typename DelayLineType>
+TankType PlateReverb<SampleType, TankType, halfPrecisionDelays>::calculateReverseLattice (TankType sample, TankType coefficient, DelayLineType& delayLine)
 {
-    float delayOutput = delayLine.getSample (0);
-    float delayInput = sample - (delayOutput * coefficient);
-    float output = delayInput * coefficient + delayOutput;
+    TankType delayOutput = delayLine.getOutput();
+    TankType delayInput = sample + (delayOutput * coefficient);
+    TankType output = delayOutput - (delayInput * coefficient);
     delayLine.pushSample (delayInput);
 
     return output;
 }
 
-float PlateReverb::calculateReverseLattice (float sample, float coefficient, DelayLine& delayLine)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+TankType PlateReverb<SampleType, TankType, halfPrecisionDelays>::calculateModulatedReverseLattice (TankType sample, TankType coefficient, TankType delayInSamples, ModulatedDelayLine& delayLine)
 {
-    float delayOutput = delayLine.getSample (0);
-    float delayInput = sample + (delayOutput * coefficient);
-    float output = delayOutput - (delayInput * coefficient);
+    TankType delayOutput = delayLine.getSample (delayInSamples);
+    TankType delayInput = sample + (delayOutput * coefficient);
+    TankType output = delayOutput - (delayInput * coefficient);
     delayLine.pushSample (delayInput);
 
     return output;
 }
 
-float PlateReverb::calculateOnepole (float sample, float coefficient, DelayLine& delayLine)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+TankType PlateReverb<SampleType, TankType, halfPrecisionDelays>::calculateOnepole (TankType sample, TankType coefficient, OnepoleState<TankType>& state)
 {
-    float output = delayLine.getSample (0) * coefficient + sample;
-    delayLine.pushSample (output);
+    TankType output = state.getOutput() * coefficient + sample;
+    state.pushSample (output);
 
     return output;
 }
 
-float PlateReverb::processDelay (float sample, DelayLine& delayLine)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+TankType PlateReverb<SampleType, TankType, halfPrecisionDelays>::processDelay (TankType sample, LongDelayLine& delayLine)
 {
-    float delayOutput = delayLine.getSample (0);
+    TankType delayOutput = delayLine.getOutput();
     delayLine.pushSample (sample);
     
     return delayOutput;
 }
 
-int PlateReverb::clamp (int low, int high, int value)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+float PlateReverb<SampleType, TankType, halfPrecisionDelays>::getDecayDiffusion2 (float decay)
+{
+    return clamp (0.25f, 0.5f, decay + 0.15);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+double PlateReverb<SampleType, TankType, halfPrecisionDelays>::getTailLengthSeconds() const
+{
+    auto decayTarget = decaySmoother.getTargetValue();
+    auto decayDiffusion1Target = decayDiffusion1Smoother.getTargetValue();
+    auto decayDiffusion2Target = getDecayDiffusion2 (decayTarget);
+
+    // time for the input to reach the tank
+    auto inputMilliseconds = double (predelaySmoother.getTargetValue())
+                           + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::inputDiffusion1A, inputDiffusion1Smoother.getTargetValue())
+                           + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::inputDiffusion1B, inputDiffusion1Smoother.getTargetValue())
+                           + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::inputDiffusion2A, inputDiffusion2Smoother.getTargetValue())
+                           + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::inputDiffusion2B, inputDiffusion2Smoother.getTargetValue());
+
+    // one trip around both tank halves, modulation can stretch the first diffusers by their excursion
+    auto loopMilliseconds = double (2.0f * DattorroTopology::maximumExcursionMilliseconds)
+                          + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::decayDiffusion1L, decayDiffusion1Target)
+                          + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::decayDiffusion1R, decayDiffusion1Target)
+                          + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::decayDiffusion2L, decayDiffusion2Target)
+                          + DattorroTopology::maximumGroupDelayMilliseconds (DelayId::decayDiffusion2R, decayDiffusion2Target);
+
+    for (int i = 0; i < DattorroTopology::numDelays; ++i)
+        if (DattorroTopology::isTankDelay ((DelayId) i))
+            loopMilliseconds += DattorroTopology::delayTimesMilliseconds[i];
+
+    // damping only takes away high frequencies, so the low end decays by the
+    // plain loop gain. a sustained input can build up to 1 / (1 - loopGain) first
+    auto loopGain = std::pow (double (decayTarget), double (DattorroTopology::decayGainsPerTankLoop));
+    auto buildupDecibels = -Decibels::gainToDecibels (1.0 - loopGain, -200.0);
+    auto lossPerLoopDecibels = -Decibels::gainToDecibels (loopGain, -200.0);
+    auto thresholdDecibels = Decibels::gainToDecibels (double (silenceThreshold), -200.0);
+
+    auto numLoops = (buildupDecibels - thresholdDecibels) / lossPerLoopDecibels;
+
+    // plus the pass that first carries the signal from the tank input to the output taps
+    auto tankMilliseconds = (numLoops + 1.0) * loopMilliseconds;
+
+    // a diffuser with a coefficient close to 1 keeps ringing on its own even once the loop gain is tiny
+    auto ringingMilliseconds = DattorroTopology::delayTimesMilliseconds[DelayId::decayDiffusion1R]
+                             * (buildupDecibels - thresholdDecibels)
+                             / -Decibels::gainToDecibels (double (decayDiffusion1Target), -200.0);
+
+    return (inputMilliseconds + jmax (tankMilliseconds, ringingMilliseconds)) / 1000.0;
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+int PlateReverb<SampleType, TankType, halfPrecisionDelays>::clampTap (int tapInSamples, int delayInSamples)
+{
+    // output taps are read one sample behind the write head
+    jassert (tapInSamples >= 0 && tapInSamples < delayInSamples);
+    return clamp (0, delayInSamples - 1, tapInSamples);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+int PlateReverb<SampleType, TankType, halfPrecisionDelays>::clamp (int low, int high, int value)
 {
     if (value < low)
         return low;
@@ -270,7 +1402,8 @@ int PlateReverb::clamp (int low, int high, int value)
         return value;
 }
 
-float PlateReverb::clamp (float low, float high, float value)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+float PlateReverb<SampleType, TankType, halfPrecisionDelays>::clamp (float low, float high, float value)
 {
     if (value < low)
         return low;
@@ -280,43 +1413,90 @@ float PlateReverb::clamp (float low, float high, float value)
         return value;
 }
 
-void PlateReverb::setPredelayTime (int newPredelayTime)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setParameters (const Parameters& newParameters)
 {
-    predelayTime = clamp (0, 1000, newPredelayTime);
+    setPredelayTime (newParameters.predelayTime);
+    setDecay (newParameters.decay);
+    setDecayDiffusion1 (newParameters.decayDiffusion1);
+    setInputDiffusion1 (newParameters.inputDiffusion1);
+    setInputDiffusion2 (newParameters.inputDiffusion2);
+    setBandwidth (newParameters.bandwidth);
+    setDamping (newParameters.damping);
+    setMix (newParameters.mix);
+    setModulationRate (newParameters.modulationRate);
+    setModulationDepth (newParameters.modulationDepth);
 }
 
-void PlateReverb::setDecay (float newDecay)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setPredelayTime (float newPredelayTime)
 {
-    decay = clamp (0.01f, 0.99f, newDecay);
-    decayDiffusion2 = clamp (0.25f, 0.5f, decay + 0.15);
+    predelaySmoother.setTargetValue (clamp (0.0f, 1000.0f, newPredelayTime));
 }
 
-void PlateReverb::setDecayDiffusion1 (float newDecayDiffusion1)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setDecay (float newDecay)
 {
-    decayDiffusion1 = clamp (0.01f, 0.99f, newDecayDiffusion1);
+    decaySmoother.setTargetValue (clamp (0.01f, 0.99f, newDecay));
 }
 
-void PlateReverb::setInputDiffusion1 (float newInputDiffusion1)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setDecayDiffusion1 (float newDecayDiffusion1)
 {
-    inputDiffusion1 = clamp(0.01f, 0.99f, newInputDiffusion1);
+    decayDiffusion1Smoother.setTargetValue (clamp (0.01f, 0.99f, newDecayDiffusion1));
 }
 
-void PlateReverb::setInputDiffusion2 (float newInputDiffusion2)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setInputDiffusion1 (float newInputDiffusion1)
 {
-    inputDiffusion2 = clamp(0.01f, 0.99f, newInputDiffusion2);
+    inputDiffusion1Smoother.setTargetValue (clamp(0.01f, 0.99f, newInputDiffusion1));
 }
 
-void PlateReverb::setBandwidth (float newBandwidth)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setInputDiffusion2 (float newInputDiffusion2)
 {
-    bandwidth = clamp (0.0000001f, 0.9999999f, newBandwidth);
+    inputDiffusion2Smoother.setTargetValue (clamp(0.01f, 0.99f, newInputDiffusion2));
 }
 
-void PlateReverb::setDamping (float newDamping)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setBandwidth (float newBandwidth)
 {
-    damping = clamp (0.0f, 0.9999999f, newDamping);
+    bandwidthSmoother.setTargetValue (clamp (0.0000001f, 0.9999999f, newBandwidth));
 }
 
-void PlateReverb::setMix(float newMix)
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setDamping (float newDamping)
 {
-    mix = clamp (0.0f, 1.0f, newMix);
-}
\ No newline at end of file
+    dampingSmoother.setTargetValue (clamp (0.0f, 0.9999999f, newDamping));
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setMix(float newMix)
+{
+    mixSmoother.setTargetValue (clamp (0.0f, 1.0f, newMix));
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setModulationRate (float newModulationRate)
+{
+    modulationRate = clamp (0.01f, 10.0f, newModulationRate);
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setModulationDepth (float newModulationDepth)
+{
+    modulationDepthSmoother.setTargetValue (clamp (0.0f, 1.0f, newModulationDepth));
+}
+
+template <typename SampleType, typename TankType, bool halfPrecisionDelays>
+void PlateReverb<SampleType, TankType, halfPrecisionDelays>::setSilenceThreshold (float newThresholdDecibels)
+{
+    // decibelsToGain treats anything below its floor as silence, so pass one lower than ours
+    silenceThreshold = Decibels::decibelsToGain (clamp (-180.0f, 0.0f, newThresholdDecibels), -200.0f);
+}
+
+template class PlateReverb<float>;
+template class PlateReverb<double>;
+template class PlateReverb<float, double>;
+template class PlateReverb<float, float, true>;
+template class PlateReverb<float, double, true>;
@@ -11,19 +11,120 @@
 #pragma once
 #include <JuceHeader.h>
 #include "DelayLine.h"
+#include "DattorroTopology.h"
+#include "HalfBandFilter.h"
+#include "PlateReverbProfiler.h"
 
+// a consistent set of all parameter values, in their plain units
+struct PlateReverbParameters
+{
+    float predelayTime = 0.0f;
+    float decay = 0.5f;
+    float decayDiffusion1 = 0.7f;
+    float inputDiffusion1 = 0.75f;
+    float inputDiffusion2 = 0.625f;
+    float bandwidth = 0.9995f;
+    float damping = 0.0005f;
+    float mix = 0.5f;
+    float modulationRate = 1.0f;
+    float modulationDepth = 0.0f;
+};
+
+// linear peak and RMS levels of the engine's signals over one processBlock call
+struct PlateReverbLevels
+{
+    float inputPeak = 0.0f;
+    float inputRms = 0.0f;
+    float wetPeak = 0.0f;
+    float wetRms = 0.0f;
+    float tankPeak = 0.0f;
+    float tankRms = 0.0f;
+};
+
+// processing tiers, best first. each lower one trades some high frequency detail for CPU
+enum class PlateReverbQuality
+{
+    full,   // the whole network at the host rate
+    eco     // the tank and its output taps at half the host rate, the tail loses what lies above about 10 kHz at 48 kHz
+};
+
+// a parameter snapshot that takes effect sampleOffset samples into a block
+struct PlateReverbParameterChange
+{
+    int sampleOffset = 0;
+    PlateReverbParameters parameters;
+};
+
+/*
+    SampleType is the precision of the audio passed in and out and of the
+    feed-forward input chain. TankType is the precision of the recirculating
+    tank, the only part where rounding errors accumulate, so
+    PlateReverb<float, double> keeps float I/O with a double-precision tail.
+
+    halfPrecisionDelays stores the predelay and the four long tank delays,
+    the bulk of the engine's memory, as HalfFloat instead. That roughly
+    halves the footprint at the cost of a noise floor about 60 dB below
+    the wet signal.
+
+    Instantiated for <float>, <double>, <float, double>, <float, float, true>
+    and <float, double, true>.
+*/
+template <typename SampleType, typename TankType = SampleType, bool halfPrecisionDelays = false>
 class PlateReverb
 {
 public:
+    using Parameters = PlateReverbParameters;
+    using ParameterChange = PlateReverbParameterChange;
+    using Levels = PlateReverbLevels;
+    using Quality = PlateReverbQuality;
+
     PlateReverb();
     
-    void prepareToPlay (double sampleRate);
+    void prepareToPlay (double sampleRate, int maximumBlockSize);
+
+    /*  Sizes all storage for up to this sample rate and block size from the
+        next prepareToPlay on, so preparing again within them only re-indexes
+        the storage already there instead of allocating. 0 sizes for each
+        prepareToPlay call alone.
+    */
+    void reserve (double maximumSampleRate, int maximumBlockSize);
+
+    // frees every delay line and scratch buffer, prepareToPlay has to run again before processing
+    void releaseResources();
+
+    /*  Empties the network and jumps every parameter to its target, as if
+        just prepared, without touching the storage. Safe on the audio
+        thread, it costs one pass over the delay lines.
+    */
+    void reset();
 
-    void processBlock (juce::AudioBuffer<float>& buffer, int numSamples, int numChannels);
+    /*  Jumps every parameter to its target without touching the network,
+        e.g. after setParameters() on an engine that is silent anyway.
+        Unlike reset() it doesn't pass over the delay lines.
+    */
+    void skipSmoothing();
+
+    /*  Processes the first numChannels channels of the buffer in place. A
+        single channel is taken as mono input, its wet signal is the mean of
+        the two tank outputs. Channels past the second are left alone.
+    */
+    void processBlock (juce::AudioBuffer<SampleType>& buffer, int numSamples, int numChannels);
+
+    /*  Sample-accurate automation: the block is split at every change, which
+        starts its ramp right at its offset instead of at the block start.
+        Changes have to be sorted by offset, later ones than numSamples are
+        applied at the end of the block.
+    */
+    void processBlock (juce::AudioBuffer<SampleType>& buffer, int numSamples, int numChannels,
+                       const ParameterChange* changes, int numChanges);
+
+    // applies a whole snapshot, the coefficients ramp to their new values at control rate
+    void setParameters (const Parameters& newParameters);
 
     // setter functions for gui tests
 
-    void setPredelayTime (int newPredelayTime);
+    // in milliseconds, 0 .. 1000. the tap glides to a new time instead of jumping
+    void setPredelayTime (float newPredelayTime);
 
     void setDecay (float newDecay);
 
@@ -39,71 +140,428 @@ public:
 
     void setMix (float newMix);
 
+    // LFO rate in Hz of the tank modulation
+    void setModulationRate (float newModulationRate);
+
+    // 0 .. 1 of Dattorro's maximum excursion, 0 switches modulation off
+    void setModulationDepth (float newModulationDepth);
+
+    // level below which input and tail count as silence, in dBFS
+    void setSilenceThreshold (float newThresholdDecibels);
+
+    /*  True while the tank is asleep: the tail has decayed below the silence
+        threshold, so the network is cleared and skipped until the input
+        rises above it again. Safe to poll from any thread.
+    */
+    bool isSleeping() const noexcept { return sleeping.load (std::memory_order_relaxed); }
+
+    /*  Estimated time a full-scale input needs to ring out below the silence
+        threshold, for the current parameter targets. Errs on the long side:
+        every allpass is assumed to hold energy for its longest group delay.
+    */
+    double getTailLengthSeconds() const;
+
+    /*  From the next prepareToPlay on, runs separate predelay, bandwidth and
+        input diffusion chains for the left and right input and feeds each
+        into the half of the tank the output on its side is mostly tapped
+        from, so a stereo source keeps its image in the tail. Both chains run as one block of interleaved
+        pairs, which costs well under twice the single chain. Off by
+        default, the inputs are then summed to mono as in the paper.
+    */
+    void setTrueStereoEnabled (bool shouldEnable) noexcept { trueStereoEnabled = shouldEnable; }
+
+    // whether the engine was prepared with separate input chains
+    bool isTrueStereo() const noexcept { return trueStereoPrepared; }
+
+    /*  Makes the eco tier available from the next prepareToPlay on, which
+        adds a half-rate copy of the tank to the delay line arena. Off by
+        default, the engine then always runs at the full tier.
+    */
+    void setQualityTiersEnabled (bool shouldEnable) noexcept { qualityTiersEnabled = shouldEnable; }
+
+    /*  Selects the tier to run at. A change while playing hands the tail
+        over to the new tier's tank and crossfades into it over 50 ms.
+    */
+    void setQuality (Quality newQuality) noexcept { selectedQuality = newQuality; }
+
+    /*  Lets the engine pick the tier itself. It steps down one once its
+        average processBlock time exceeds cpuBudget of the audio time it
+        covered, e.g. 0.1 for 10%, and back up once that average has stayed
+        below half the budget. 0 returns to the tier from setQuality().
+    */
+    void setAutomaticQuality (float cpuBudget) noexcept;
+
+    // the tier the output currently comes from, safe to poll from any thread
+    Quality getQuality() const noexcept { return currentQuality.load (std::memory_order_relaxed); }
+
+    // off by default, measuring costs a few more passes over every block
+    void setMeteringEnabled (bool shouldMeter) noexcept { meteringEnabled = shouldMeter; }
+
+    /*  Levels of the stereo input, the wet output before the mix and the
+        signal circulating in the tank, over the last processBlock call.
+        All zero while metering is disabled. Call from the audio thread.
+    */
+    Levels getLevels() const noexcept;
+
+    // bytes this instance occupies, including the delay line arena and scratch buffers
+    size_t getFootprintInBytes() const;
+
+   #if DATTORRO_PROFILE_STAGES
+    // stage timings of every processBlock call since prepareToPlay or the profiler's last reset()
+    PlateReverbProfiler& getProfiler() noexcept { return profiler; }
+    const PlateReverbProfiler& getProfiler() const noexcept { return profiler; }
+   #endif
+
 private:
-    float calculateLattice (float sample, float coefficient, DelayLine& delayLine);
+    // the benchmark tool times the processing stages below one by one
+    friend struct PlateReverbStages;
 
-    float calculateReverseLattice (float sample, float coefficient, DelayLine& delayLine);
+    // interpolation used by the modulated decay diffusers
+    using ModulationInterpolation = DelayInterpolation::Cubic;
 
-    float calculateOnepole (float sample, float coefficient, DelayLine& delayLine);
+    using InputDelayLine = DelayLine<SampleType>;
+    using TankDelayLine = DelayLine<TankType>;
+    using ModulatedDelayLine = DelayLine<TankType, ModulationInterpolation>;
 
-    float processDelay (float sample, DelayLine& delayLine);
+    template <typename Type>
+    using LongDelayStorage = std::conditional_t<halfPrecisionDelays, HalfFloat, Type>;
 
-    int clamp (int low, int high, int value);
+    // interpolation used by the predelay tap while it glides
+    using PredelayInterpolation = DelayInterpolation::Linear;
 
-    float clamp (float low, float high,  float value);
+    using PredelayLine = DelayLine<SampleType, PredelayInterpolation, LongDelayStorage<SampleType>>;
+    using LongDelayLine = DelayLine<TankType, DelayInterpolation::None, LongDelayStorage<TankType>>;
 
-    // parameters
-    int predelayTime;
-    float decay;
-    float decayDiffusion1;
-    float decayDiffusion2;
-    float inputDiffusion1;
-    float inputDiffusion2;
-    float bandwidth;
-    float damping;
-    float mix;
+    /*  History of a one-pole filter, kept in the engine object instead of a
+        delay line of its own. The feedback is read two samples back, as the
+        original engine did with its 2-sample delay lines.
+    */
+    template <typename Type>
+    struct OnepoleState
+    {
+        Type getOutput() const noexcept { return history[(size_t) index]; }
 
-    // hash maps to store delay times
-    HashMap<String, float> delayTimesMilsec;
-    HashMap<String, int> delayTimesSamp;
+        void pushSample (Type sample) noexcept
+        {
+            history[(size_t) index] = sample;
+            index ^= 1;
+        }
 
-    // all delay lines
-    DelayLine predelay;
+        void clear() noexcept
+        {
+            history = {};
+            index = 0;
+        }
 
-    DelayLine delayLeft1;
-    DelayLine delayLeft2;
-    DelayLine delayRight1;
-    DelayLine delayRight2;
-    
-    DelayLine bandwidthOnepole;
-    DelayLine dampingOnepoleLeft;
-    DelayLine dampingOnepoleRight;
-
-    DelayLine inputDiffusion1A;
-    DelayLine inputDiffusion1B;
-    DelayLine inputDiffusion2A;
-    DelayLine inputDiffusion2B;
-    DelayLine decayDiffusion1L;
-    DelayLine decayDiffusion2L;
-    DelayLine decayDiffusion1R;
-    DelayLine decayDiffusion2R;
-
-    // delay times in samples for output and predelay
-    int samplesPredelayTap;
-
-    int samplesDelayRight1_TapLeft1;
-    int samplesDelayRight1_TapLeft2;
-    int samplesDecayDiffusion2R_TapLeft;
-    int samplesDelayRight2_TapLeft;
-    int samplesDelayLeft1_TapLeft;
-    int samplesDecayDiffusion2L_TapLeft;
-    int samplesDelayLeft2_TapLeft;
-
-    int samplesDelayLeft1_TapRight1;
-    int samplesDelayLeft1_TapRight2;
-    int samplesDecayDiffusion2L_TapRight;
-    int samplesDelayLeft2_TapRight;
-    int samplesDelayRight1_TapRight;
-    int samplesDecayDiffusion2R_TapRight;
-    int samplesDelayRight2_TapRight;
+        std::array<Type, 2> history{};
+        int index{ 0 };
+    };
+
+    /*  Both input chains' one-poles on a block of interleaved pairs. The
+        feedback two frames back is four samples back, so the recursion has
+        a distance the loop can be vectorised over.
+    */
+    struct InterleavedOnepoleState
+    {
+        void clear() noexcept { history = {}; }
+
+        // the last four outputs, oldest first
+        std::array<SampleType, 4> history{};
+    };
+
+    static constexpr int numQualityTiers = 2;
+
+    // the recirculating part of the network at one rate, the eco tier runs a second one at half the host rate
+    struct Tank
+    {
+        // the four long delays, indexed by DattorroTopology::DelayId. the other slots stay unused
+        std::array<LongDelayLine, DattorroTopology::numDelays> longDelayLines;
+
+        // the unmodulated decay diffusers, indexed the same way
+        std::array<TankDelayLine, DattorroTopology::numDelays> delayLines;
+
+        ModulatedDelayLine decayDiffusion1L;
+        ModulatedDelayLine decayDiffusion1R;
+
+        OnepoleState<TankType> dampingOnepoleLeft;
+        OnepoleState<TankType> dampingOnepoleRight;
+
+        // output tap delay times in samples
+        std::array<int, DattorroTopology::numTapsPerChannel> samplesLeftOutputTaps{};
+        std::array<int, DattorroTopology::numTapsPerChannel> samplesRightOutputTaps{};
+
+        // the damping coefficient at this tank's rate
+        TankType damping{ 0 };
+
+        float maximumExcursionSamples{ 0.0f };
+        float lfoSine{ 0.0f };
+        float lfoCosine{ 1.0f };
+
+        double sampleRate{ 0.0 };
+
+        // samples the tank processed in the last block, for the tank meter
+        int numBlockSamples{ 0 };
+    };
+
+    // calls visit (delayLine, delayInSamples, extraCapacity) for every line in DattorroTopology::processingOrder,
+    // then for the eco tank's lines while tiers are enabled
+    template <typename Visitor>
+    void visitDelayLines (double sampleRate, int blockSize, Visitor&& visit);
+
+    template <typename Visitor>
+    static void visitTankLine (Tank& tank, DattorroTopology::DelayId id, int delayInSamples, int excursion, int blockSize, Visitor&& visit);
+
+    // sets up the tank's taps, LFO and filters for its rate. the eco taps are read tapAdvance samples earlier
+    void prepareTank (Tank& tank, double tankSampleRate, int tapAdvance);
+
+    // arena bytes the whole network takes at this rate and block size
+    size_t getArenaSize (double sampleRate, int blockSize);
+
+    void allocateDelayLines (double sampleRate, int blockSize, size_t storageSize);
+
+    template <typename DelayLineType>
+    static size_t getStorageBytes (int delayInSamples, int extraCapacity);
+
+    static int getExcursionSamples (double sampleRate);
+
+    // runs the engine over part of the host buffer in control blocks
+    void processSubBlocks (SampleType* writeBufferL, SampleType* writeBufferR, int numSamples);
+
+    // numSamples frames of one sample, or of an interleaved pair in true stereo
+    void processPredelay (SampleType* samples, int numSamples);
+
+    // a mono input has no right channel. the outputs are the same block unless in true stereo
+    void processInputChain (const SampleType* inputLeft, const SampleType* inputRight,
+                            SampleType* outputLeft, SampleType* outputRight, int numSamples);
+
+    // both input chains over one block of interleaved pairs
+    void processStereoInputChain (const SampleType* inputLeft, const SampleType* inputRight,
+                                  SampleType* outputLeft, SampleType* outputRight, int numSamples);
+
+    // runs the tier the output comes from, and while a tier change fades the one it goes to
+    void processTiers (const SampleType* inputLeft, const SampleType* inputRight,
+                       SampleType* outputLeft, SampleType* outputRight, int numSamples);
+
+    void processTier (Quality quality, const SampleType* inputLeft, const SampleType* inputRight,
+                      SampleType* outputLeft, SampleType* outputRight, int numSamples);
+
+    // inputLeft feeds the left half of the tank and inputRight the right one
+    void processTank (Tank& tank, const SampleType* inputLeft, const SampleType* inputRight,
+                      SampleType* outputLeft, SampleType* outputRight, int numSamples);
+
+    void gatherOutputTaps (Tank& tank, SampleType* outputLeft, SampleType* outputRight, int numSamples);
+
+    void addOutputTap (Tank& tank, SampleType* output, int numSamples, DattorroTopology::DelayId id, int tapInSamples, SampleType gain);
+
+    template <bool modulated>
+    void processTankSamples (Tank& tank, const SampleType* inputLeft, const SampleType* inputRight, int numSamples);
+
+    void advanceLfo (Tank& tank, int numSamples);
+
+    Quality getTargetQuality() const noexcept;
+
+    void beginTierFade (Quality newQuality);
+
+    void finishTierFade();
+
+    void updateAutomaticQuality (int64 callbackTicks, int numSamples);
+
+    // copies the tail from one tank into the other, resampled to its rate
+    static void transferTank (const Tank& source, Tank& destination);
+
+    // fills the destination with the source's history at twice or half the source's rate
+    template <typename DestinationLine, typename SourceLine>
+    static void resampleHistory (DestinationLine& destination, const SourceLine& source, bool halving, int extraHistory);
+
+    void processLatticeBlock (SampleType* samples, int numSamples, SampleType coefficient, InputDelayLine& delayLine);
+
+    void processOnepoleBlock (SampleType* samples, int numSamples, SampleType coefficient, OnepoleState<SampleType>& state);
+
+    void processInterleavedOnepoleBlock (SampleType* samples, int numSamples, SampleType coefficient, InterleavedOnepoleState& state);
+
+    TankType calculateLattice (TankType sample, TankType coefficient, TankDelayLine& delayLine);
+
+    template <typename DelayLineType>
+    TankType calculateReverseLattice (TankType sample, TankType coefficient, DelayLineType& delayLine);
+
+    TankType calculateModulatedReverseLattice (TankType sample, TankType coefficient, TankType delayInSamples, ModulatedDelayLine& delayLine);
+
+    TankType calculateOnepole (TankType sample, TankType coefficient, OnepoleState<TankType>& state);
+
+    TankType processDelay (TankType sample, LongDelayLine& delayLine);
+
+    void updateCoefficients (int numSamples);
+
+    void updateSilenceTracking (SampleType inputPeak, const SampleType* outputLeft, const SampleType* outputRight, int numSamples);
+
+    void clearDelayLines();
+
+    bool isSmoothing() const;
+
+    int clampTap (int tapInSamples, int delayInSamples);
+
+    static float getDecayDiffusion2 (float decay);
+
+    static int clamp (int low, int high, int value);
+
+    static float clamp (float low, float high,  float value);
+
+    // parameters, the input chain and mix run at the I/O precision and the tank at its own.
+    // the damping coefficient depends on the tank's rate and is kept in each Tank
+    TankType decay;
+    TankType decayDiffusion1;
+    TankType decayDiffusion2;
+    SampleType inputDiffusion1;
+    SampleType inputDiffusion2;
+    SampleType bandwidth;
+    SampleType mix;
+
+    // parameter ramps, the values above are advanced from these once per control block
+    static constexpr int controlRateInterval = 32;
+    static constexpr double smoothingTimeSeconds = 0.05;
+
+    SmoothedValue<float> decaySmoother;
+    SmoothedValue<float> decayDiffusion1Smoother;
+    SmoothedValue<float> inputDiffusion1Smoother;
+    SmoothedValue<float> inputDiffusion2Smoother;
+    SmoothedValue<float> bandwidthSmoother;
+    SmoothedValue<float> dampingSmoother;
+    SmoothedValue<float> mixSmoother;
+
+    // the predelay tap in milliseconds, ramped per sample. long enough that
+    // sweeping across the whole range glides instead of crackling
+    static constexpr double predelaySmoothingTimeSeconds = 0.2;
+
+    SmoothedValue<float> predelaySmoother;
+
+    // tank modulation, a quadrature LFO advanced once per lfoUpdateInterval
+    // samples with the delay times ramped linearly in between
+    static constexpr int lfoUpdateInterval = 128;
+
+    float modulationRate;
+    float modulationDepth;
+    SmoothedValue<float> modulationDepthSmoother;
+
+    // silence detection. the tank goes to sleep once input and wet output have
+    // stayed below the threshold for long enough to drain the whole network
+    static constexpr float defaultSilenceThresholdDecibels = -120.0f;
+
+    SampleType silenceThreshold;
+    int samplesBelowThreshold{ 0 };
+    int networkDrainSamples{ 0 };
+    std::atomic<bool> sleeping{ false };
+
+    // metering, summed over one processBlock call
+    struct LevelSum
+    {
+        template <typename Type>
+        void add (const Type* samples, int numSamples) noexcept;
+
+        // samples that were silent, e.g. the wet output while the tank sleeps
+        void addSilence (int numSamples) noexcept { numValues += numSamples; }
+
+        void clear() noexcept { *this = {}; }
+
+        float getRms() const noexcept { return numValues > 0 ? (float) std::sqrt (sumOfSquares / numValues) : 0.0f; }
+
+        double peak{ 0.0 };
+        double sumOfSquares{ 0.0 };
+        int numValues{ 0 };
+    };
+
+    bool meteringEnabled{ false };
+    LevelSum inputLevel;
+    LevelSum wetLevel;
+    LevelSum tankLevel;
+
+    void clearLevels() noexcept;
+
+    void measureLevels (const SampleType* inputLeft, const SampleType* inputRight,
+                        const SampleType* outputLeft, const SampleType* outputRight, int numSamples);
+
+    // quality tiers. a change hands the tail over to the new tier and crossfades into it,
+    // the automatic mode averages the load over a while and holds each tier for a second at least
+    static constexpr double tierFadeSeconds = 0.05;
+    static constexpr double loadAveragingSeconds = 0.25;
+    static constexpr double tierHoldSeconds = 1.0;
+    static constexpr float stepUpLoadRatio = 0.5f;
+
+    bool qualityTiersEnabled{ false };
+    bool tiersPrepared{ false };
+    Quality selectedQuality{ Quality::full };
+    Quality automaticQuality{ Quality::full };
+    Quality activeQuality{ Quality::full };
+    Quality fadingQuality{ Quality::full };
+    std::atomic<Quality> currentQuality{ Quality::full };
+
+    int tierFadeSamples{ 1 };
+    int fadeSamplesRemaining{ 0 };
+
+    float cpuBudget{ 0.0f };
+    double averageLoad{ 0.0 };
+    int tierHoldSamples{ 0 };
+    int samplesSinceTierChange{ 0 };
+
+    // between the input chain and the eco tank, and between its taps and the output
+    HalfBandDecimator<SampleType> ecoDecimator;
+    HalfBandDecimator<SampleType> ecoDecimatorRight;
+    HalfBandInterpolator<SampleType> ecoInterpolatorLeft;
+    HalfBandInterpolator<SampleType> ecoInterpolatorRight;
+
+   #if DATTORRO_PROFILE_STAGES
+    PlateReverbProfiler profiler;
+   #endif
+
+    double currentSampleRate{ 0.0 };
+
+    // true stereo, the input lines then hold interleaved pairs at twice their length
+    bool trueStereoEnabled{ false };
+    bool trueStereoPrepared{ false };
+
+    // per-block scratch space, the channels from the eco tank's input on only exist while tiers are enabled
+    enum BlockChannel
+    {
+        tankInputChannel,
+        outputLeftChannel,
+        outputRightChannel,
+        tankInputRightChannel,
+        ecoTankInputChannel,
+        ecoTankInputRightChannel,
+        ecoOutputLeftChannel,
+        ecoOutputRightChannel,
+        fadeLeftChannel,
+        fadeRightChannel,
+        numBlockChannels
+    };
+
+    AudioBuffer<SampleType> blockBuffer;
+    int maximumBlockSize{ 0 };
+
+    // both input chains' block as interleaved pairs, only allocated in true stereo
+    HeapBlock<SampleType> interleavedBlock;
+    int interleavedCapacity{ 0 };
+
+    PredelayLine predelayLine;
+
+    // the input diffusers' delay lines, indexed by DattorroTopology::DelayId.
+    // the other slots stay unused
+    std::array<InputDelayLine, DattorroTopology::numDelays> inputDelayLines;
+
+    OnepoleState<SampleType> bandwidthOnepole;
+    InterleavedOnepoleState interleavedBandwidthOnepole;
+
+    // indexed by Quality, the eco one only has storage while tiers are enabled
+    std::array<Tank, numQualityTiers> tanks;
+
+    // storage of every delay line above, one cache-aligned block laid out in
+    // DattorroTopology::processingOrder
+    static constexpr size_t cacheLineSize = 64;
+
+    HeapBlock<char> arena;
+    size_t arenaSize{ 0 };
+
+    double reservedSampleRate{ 0.0 };
+    int reservedBlockSize{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PlateReverb)
 };
@@ -0,0 +1,197 @@
+/*
+  ==============================================================================
+
+    PlateReverbProfiler.cpp
+
+  ==============================================================================
+*/
+
+#include "PlateReverbProfiler.h"
+
+const char* PlateReverbProfiler::getStageName (Stage stage) noexcept
+{
+    switch (stage)
+    {
+        case inputChain:    return "input chain";
+        case tankLeft:      return "tank left";
+        case tankRight:     return "tank right";
+        case outputTaps:    return "output taps";
+        case numStages:     break;
+    }
+
+    return "";
+}
+
+void PlateReverbProfiler::prepare (int maximumTraceEvents)
+{
+    trace.resize ((size_t) jmax (1, maximumTraceEvents));
+
+    // calibrated once, preparing again only resizes the trace
+    if (ticksPerSecond <= 0.0)
+        calibrate();
+
+    reset();
+}
+
+void PlateReverbProfiler::calibrate()
+{
+   #if DATTORRO_PROFILE_USE_RDTSC
+    // the time stamp counter runs at a fixed rate on anything recent, measured against the clock
+    auto clockStart = Time::getHighResolutionTicks();
+    auto ticksStart = getTicks();
+    auto clockEnd = clockStart + Time::getHighResolutionTicksPerSecond() / 50;
+
+    while (Time::getHighResolutionTicks() < clockEnd)
+        ;
+
+    auto clockSeconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - clockStart);
+    ticksPerSecond = (double) (getTicks() - ticksStart) / clockSeconds;
+   #else
+    ticksPerSecond = (double) Time::getHighResolutionTicksPerSecond();
+   #endif
+
+    // the average over a run of back to back reads, a single pair underestimates what a read holds up the loop around it
+    constexpr int numReads = 1000;
+    auto first = getTicks();
+
+    for (int i = 0; i < numReads - 1; ++i)
+        getTicks();
+
+    readOverhead = (getTicks() - first) / numReads;
+}
+
+void PlateReverbProfiler::reset() noexcept
+{
+    stageTicks = {};
+    callbackTicks = 0;
+    numCallbacks = 0;
+    numSamplesProcessed = 0;
+    histogram = {};
+
+    traceWriteIndex = 0;
+    traceWrapped = false;
+}
+
+void PlateReverbProfiler::endCallback (int numSamples) noexcept
+{
+    auto duration = getTicks() - callbackStart;
+
+    callbackTicks += duration;
+    numCallbacks++;
+    numSamplesProcessed += numSamples;
+
+    auto microseconds = toSeconds (duration) * 1.0e6;
+    auto bucket = microseconds < 1.0 ? 0 : 1 + (int) std::log2 (microseconds);
+    histogram[(size_t) jmin (bucket, numHistogramBuckets - 1)]++;
+
+    addTraceEvent (callbackEvent, callbackStart, duration);
+}
+
+void PlateReverbProfiler::addStage (Stage stage, Ticks start, Ticks end) noexcept
+{
+    stageTicks[(size_t) stage] += end - start;
+    addTraceEvent (stage, start, end - start);
+}
+
+void PlateReverbProfiler::addTank (Ticks start, Ticks end, Ticks sampledLeftTicks, Ticks sampledRightTicks, int numSampledSamples) noexcept
+{
+    auto tankTicks = jmax ((Ticks) 0, end - start - 3 * readOverhead * numSampledSamples);
+    auto sampledTicks = sampledLeftTicks + sampledRightTicks;
+    auto leftShare = sampledTicks > 0 ? (double) sampledLeftTicks / (double) sampledTicks : 0.5;
+
+    auto leftTicks = (Ticks) ((double) tankTicks * leftShare);
+    auto rightTicks = tankTicks - leftTicks;
+
+    stageTicks[tankLeft] += leftTicks;
+    stageTicks[tankRight] += rightTicks;
+
+    // shown back to back, they really take turns every sample
+    addTraceEvent (tankLeft, start, leftTicks);
+    addTraceEvent (tankRight, start + leftTicks, rightTicks);
+}
+
+void PlateReverbProfiler::addTraceEvent (int stage, Ticks start, Ticks duration) noexcept
+{
+    if (trace.empty())
+        return;
+
+    trace[(size_t) traceWriteIndex] = { start, duration, stage };
+
+    if (++traceWriteIndex == (int) trace.size())
+    {
+        traceWriteIndex = 0;
+        traceWrapped = true;
+    }
+}
+
+String PlateReverbProfiler::getSummary() const
+{
+    String summary;
+
+    if (numCallbacks == 0 || numSamplesProcessed == 0)
+        return "No callbacks profiled\n";
+
+    auto callbackSeconds = getCallbackSeconds();
+    auto nanosecondsPerSample = [this] (double seconds) { return seconds * 1.0e9 / (double) numSamplesProcessed; };
+
+    auto addRow = [&] (const String& name, double seconds)
+    {
+        summary << name.paddedRight (' ', 16)
+                << String (nanosecondsPerSample (seconds), 2).paddedLeft (' ', 10) << " ns/sample"
+                << String (100.0 * seconds / callbackSeconds, 1).paddedLeft (' ', 8) << " %\n";
+    };
+
+    auto stagesSeconds = 0.0;
+
+    for (int i = 0; i < numStages; ++i)
+    {
+        addRow (getStageName ((Stage) i), getStageSeconds ((Stage) i));
+        stagesSeconds += getStageSeconds ((Stage) i);
+    }
+
+    // predelay smoothing, silence tracking, the mix and whatever else runs between the stages
+    addRow ("other", jmax (0.0, callbackSeconds - stagesSeconds));
+    addRow ("processBlock", callbackSeconds);
+
+    summary << "\n" << String (numCallbacks) << " callbacks, "
+            << String (callbackSeconds * 1.0e6 / (double) numCallbacks, 2) << " us on average\n";
+
+    for (int i = 0; i < numHistogramBuckets; ++i)
+    {
+        if (histogram[(size_t) i] == 0)
+            continue;
+
+        auto range = i == 0 ? String ("< 1 us")
+                            : String (1 << (i - 1)) + (i == numHistogramBuckets - 1 ? " us and up" : " - " + String (1 << i) + " us");
+
+        summary << range.paddedRight (' ', 20) << String (histogram[(size_t) i]) << "\n";
+    }
+
+    return summary;
+}
+
+void PlateReverbProfiler::writeChromeTrace (OutputStream& stream) const
+{
+    // complete events ("ph": "X") in microseconds since the oldest one kept, callbacks enclosing their stages
+    auto numEvents = traceWrapped ? (int) trace.size() : traceWriteIndex;
+    auto firstEvent = traceWrapped ? traceWriteIndex : 0;
+    auto origin = std::numeric_limits<Ticks>::max();
+
+    for (int i = 0; i < numEvents; ++i)
+        origin = jmin (origin, trace[(size_t) ((firstEvent + i) % (int) trace.size())].start);
+
+    stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+    for (int i = 0; i < numEvents; ++i)
+    {
+        const auto& event = trace[(size_t) ((firstEvent + i) % (int) trace.size())];
+        auto name = event.stage == callbackEvent ? "processBlock" : getStageName ((Stage) event.stage);
+
+        stream << (i > 0 ? ",\n" : "")
+               << "{\"name\":\"" << name << "\",\"cat\":\"PlateReverb\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+               << ",\"ts\":" << String (toSeconds (event.start - origin) * 1.0e6, 3)
+               << ",\"dur\":" << String (toSeconds (event.duration) * 1.0e6, 3) << "}";
+    }
+
+    stream << "\n]}\n";
+}
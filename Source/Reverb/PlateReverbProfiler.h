@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    PlateReverbProfiler.h
+
+    Optional per-stage timing of PlateReverb::processBlock. Building with
+    DATTORRO_PROFILE_STAGES=1 gives every engine a profiler that counts
+    CPU ticks for the input chain, each tank half and the output taps,
+    keeps a histogram of whole callback times and records a trace that
+    chrome://tracing or Perfetto can open. Left at 0, the instrumentation
+    macros expand to nothing and the engine carries no profiler at all.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+#ifndef DATTORRO_PROFILE_STAGES
+ #define DATTORRO_PROFILE_STAGES 0
+#endif
+
+#if DATTORRO_PROFILE_STAGES && (defined (__x86_64__) || defined (_M_X64) || defined (__i386__) || defined (_M_IX86))
+ #define DATTORRO_PROFILE_USE_RDTSC 1
+ #if defined (_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#else
+ #define DATTORRO_PROFILE_USE_RDTSC 0
+#endif
+
+class PlateReverbProfiler
+{
+public:
+    enum Stage
+    {
+        inputChain,
+        tankLeft,
+        tankRight,
+        outputTaps,
+        numStages
+    };
+
+    using Ticks = int64;
+
+    PlateReverbProfiler() = default;
+
+    // the time stamp counter where there is one, the high resolution clock elsewhere
+    static Ticks getTicks() noexcept
+    {
+       #if DATTORRO_PROFILE_USE_RDTSC
+        return (Ticks) __rdtsc();
+       #else
+        return Time::getHighResolutionTicks();
+       #endif
+    }
+
+    static const char* getStageName (Stage stage) noexcept;
+
+    /*  Sizes the trace for this many events, the oldest ones are dropped
+        once it is full, and calibrates the tick rate. Allocates, so call it
+        from prepareToPlay, not the audio thread.
+    */
+    void prepare (int maximumTraceEvents = defaultTraceEvents);
+
+    // clears totals, histogram and trace, e.g. to profile only part of a render
+    void reset() noexcept;
+
+    void beginCallback() noexcept { callbackStart = getTicks(); }
+
+    void endCallback (int numSamples) noexcept;
+
+    void addStage (Stage stage, Ticks start, Ticks end) noexcept;
+
+    /*  The tank halves alternate sample by sample, too finely to time each
+        one without the clock reads swamping them. So the whole tank is
+        timed from start to end, and split between the halves in the ratio
+        measured on every tankSampleInterval-th sample, minus the cost of
+        the three reads on each of those.
+    */
+    static constexpr int tankSampleInterval = 16;
+
+    void addTank (Ticks start, Ticks end, Ticks sampledLeftTicks, Ticks sampledRightTicks, int numSampledSamples) noexcept;
+
+    double getStageSeconds (Stage stage) const noexcept { return toSeconds (stageTicks[(size_t) stage]); }
+    double getCallbackSeconds() const noexcept { return toSeconds (callbackTicks); }
+    int64 getNumCallbacks() const noexcept { return numCallbacks; }
+    int64 getNumSamples() const noexcept { return numSamplesProcessed; }
+
+    // callbacks per duration, bucket 0 counts those under 1 us and bucket i those from 2^(i - 1) us up
+    static constexpr int numHistogramBuckets = 20;
+    const std::array<int64, numHistogramBuckets>& getCallbackHistogram() const noexcept { return histogram; }
+
+    // a table of the stages and the callback histogram, for printing
+    String getSummary() const;
+
+    // the recorded trace in the Chrome trace event format
+    void writeChromeTrace (OutputStream& stream) const;
+
+private:
+    static constexpr int defaultTraceEvents = 1 << 16;
+
+    // stage events plus the callbacks around them
+    static constexpr int callbackEvent = numStages;
+
+    struct TraceEvent
+    {
+        Ticks start;
+        Ticks duration;
+        int stage;
+    };
+
+    // measures the tick rate and what one read of the clock costs
+    void calibrate();
+
+    void addTraceEvent (int stage, Ticks start, Ticks duration) noexcept;
+
+    double toSeconds (Ticks ticks) const noexcept { return ticksPerSecond > 0.0 ? (double) ticks / ticksPerSecond : 0.0; }
+
+    std::array<Ticks, numStages> stageTicks{};
+    Ticks callbackTicks{ 0 };
+    Ticks callbackStart{ 0 };
+    int64 numCallbacks{ 0 };
+    int64 numSamplesProcessed{ 0 };
+    std::array<int64, numHistogramBuckets> histogram{};
+
+    // a ring, traceWriteIndex wraps once traceWrapped
+    std::vector<TraceEvent> trace;
+    int traceWriteIndex{ 0 };
+    bool traceWrapped{ false };
+
+    double ticksPerSecond{ 0.0 };
+    Ticks readOverhead{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PlateReverbProfiler)
+};
+
+#if DATTORRO_PROFILE_STAGES
+ // times the rest of the enclosing scope as one stage
+ #define DATTORRO_PROFILE_STAGE(profilerToUse, stage) \
+    const auto dattorroStageStart = PlateReverbProfiler::getTicks(); \
+    const auto dattorroStageEnd = juce::ScopeGuard { [&] { (profilerToUse).addStage (PlateReverbProfiler::stage, dattorroStageStart, PlateReverbProfiler::getTicks()); } }
+
+ // times the rest of the enclosing scope as one callback of numSamples
+ #define DATTORRO_PROFILE_CALLBACK(profilerToUse, numSamples) \
+    (profilerToUse).beginCallback(); \
+    const auto dattorroCallbackEnd = juce::ScopeGuard { [&] { (profilerToUse).endCallback (numSamples); } }
+#else
+ #define DATTORRO_PROFILE_STAGE(profilerToUse, stage)
+ #define DATTORRO_PROFILE_CALLBACK(profilerToUse, numSamples)
+#endif
@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    ReverbParameters.cpp
+
+  ==============================================================================
+*/
+
+#include "ReverbParameters.h"
+
+ReverbParameters::ReverbParameters (AudioProcessorValueTreeState& apvst)
+    : predelay (apvst.getRawParameterValue ("predelay")),
+      decay (apvst.getRawParameterValue ("decay")),
+      decayDiffusion1 (apvst.getRawParameterValue ("decayDif1")),
+      inputDiffusion1 (apvst.getRawParameterValue ("inputDif1")),
+      inputDiffusion2 (apvst.getRawParameterValue ("inputDif2")),
+      bandwidth (apvst.getRawParameterValue ("bandwidth")),
+      damping (apvst.getRawParameterValue ("damping")),
+      mix (apvst.getRawParameterValue ("mix")),
+      modulationRate (apvst.getRawParameterValue ("modRate")),
+      modulationDepth (apvst.getRawParameterValue ("modDepth"))
+{
+    jassert (predelay != nullptr && decay != nullptr && decayDiffusion1 != nullptr
+             && inputDiffusion1 != nullptr && inputDiffusion2 != nullptr
+             && bandwidth != nullptr && damping != nullptr && mix != nullptr
+             && modulationRate != nullptr && modulationDepth != nullptr);
+}
+
+PlateReverbParameters ReverbParameters::read() const noexcept
+{
+    PlateReverbParameters current;
+    current.predelayTime = predelay->load (std::memory_order_relaxed);
+    current.decay = decay->load (std::memory_order_relaxed);
+    current.decayDiffusion1 = decayDiffusion1->load (std::memory_order_relaxed);
+    current.inputDiffusion1 = inputDiffusion1->load (std::memory_order_relaxed);
+    current.inputDiffusion2 = inputDiffusion2->load (std::memory_order_relaxed);
+    current.bandwidth = bandwidth->load (std::memory_order_relaxed);
+    current.damping = damping->load (std::memory_order_relaxed);
+    current.mix = mix->load (std::memory_order_relaxed);
+    current.modulationRate = modulationRate->load (std::memory_order_relaxed);
+    current.modulationDepth = modulationDepth->load (std::memory_order_relaxed);
+
+    return current;
+}
+
+bool ReverbParameters::update() noexcept
+{
+    auto current = read();
+    auto changed = adopted;
+    adopted = false;
+
+    if (! hasSnapshot)
+    {
+        snapshot = lastRead = current;
+        hasSnapshot = true;
+        return true;
+    }
+
+    // each value the host moved replaces the snapshot's, the others keep what an adopted preset set
+    auto take = [&changed] (float value, float& last, float& target)
+    {
+        if (value != last)
+        {
+            last = target = value;
+            changed = true;
+        }
+    };
+
+    take (current.predelayTime, lastRead.predelayTime, snapshot.predelayTime);
+    take (current.decay, lastRead.decay, snapshot.decay);
+    take (current.decayDiffusion1, lastRead.decayDiffusion1, snapshot.decayDiffusion1);
+    take (current.inputDiffusion1, lastRead.inputDiffusion1, snapshot.inputDiffusion1);
+    take (current.inputDiffusion2, lastRead.inputDiffusion2, snapshot.inputDiffusion2);
+    take (current.bandwidth, lastRead.bandwidth, snapshot.bandwidth);
+    take (current.damping, lastRead.damping, snapshot.damping);
+    take (current.mix, lastRead.mix, snapshot.mix);
+    take (current.modulationRate, lastRead.modulationRate, snapshot.modulationRate);
+    take (current.modulationDepth, lastRead.modulationDepth, snapshot.modulationDepth);
+
+    return changed;
+}
+
+void ReverbParameters::adopt (const PlateReverbParameters& preset) noexcept
+{
+    if (! hasSnapshot)
+    {
+        lastRead = read();
+        hasSnapshot = true;
+    }
+
+    snapshot = preset;
+    adopted = true;
+}
@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    ReverbParameters.h
+
+    Reads the plugin parameters on the audio thread without any string
+    lookups and hands PlateReverb a consistent snapshot when one changed.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Reverb/PlateReverb.h"
+
+class ReverbParameters
+{
+public:
+    explicit ReverbParameters (AudioProcessorValueTreeState& apvst);
+
+    // reads every parameter once, returns true if any of them changed since the last call or a preset was adopted
+    bool update() noexcept;
+
+    /*  Makes a whole preset the snapshot at once, on the audio thread. Only
+        parameters that move after this replace its values again, so host
+        values that haven't caught up with the preset yet don't undo it.
+    */
+    void adopt (const PlateReverbParameters& preset) noexcept;
+
+    const PlateReverbParameters& getSnapshot() const noexcept { return snapshot; }
+
+    // the current values, safe to call from any thread. update() and the snapshot stay audio thread only
+    PlateReverbParameters read() const noexcept;
+
+private:
+    std::atomic<float>* predelay;
+    std::atomic<float>* decay;
+    std::atomic<float>* decayDiffusion1;
+    std::atomic<float>* inputDiffusion1;
+    std::atomic<float>* inputDiffusion2;
+    std::atomic<float>* bandwidth;
+    std::atomic<float>* damping;
+    std::atomic<float>* mix;
+    std::atomic<float>* modulationRate;
+    std::atomic<float>* modulationDepth;
+
+    PlateReverbParameters snapshot;
+    PlateReverbParameters lastRead;
+    bool hasSnapshot{ false };
+    bool adopted{ false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReverbParameters)
+};
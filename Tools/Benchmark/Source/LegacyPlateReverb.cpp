@@ -0,0 +1,18 @@
+/*
+  ==============================================================================
+
+    LegacyPlateReverb.cpp
+
+  ==============================================================================
+*/
+
+#include "LegacyPlateReverb.h"
+
+#define PlateReverb LegacyPlateReverb
+#define DelayLine LegacyDelayLine
+
+#include "../../../Old/DelayLine.cpp"
+#include "../../../Old/PlateReverb.cpp"
+
+#undef PlateReverb
+#undef DelayLine
@@ -0,0 +1,20 @@
+/*
+  ==============================================================================
+
+    LegacyPlateReverb.h
+
+    The engine in Old/ under names that don't clash with the current
+    PlateReverb and DelayLine, so both can be benchmarked side by side.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#define PlateReverb LegacyPlateReverb
+#define DelayLine LegacyDelayLine
+
+#include "../../../Old/PlateReverb.h"
+
+#undef PlateReverb
+#undef DelayLine
@@ -0,0 +1,656 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Micro-benchmarks for the plate reverb engine.
+
+    Run with --json=<file> to also write every result to a JSON file that
+    can be diffed between releases.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../../Source/Reverb/PlateReverb.h"
+#include "../../../Source/Reverb/BatchedPlateReverb.h"
+#include "LegacyPlateReverb.h"
+
+//==============================================================================
+// runs PlateReverb's processing stages one at a time, PlateReverb befriends it for this
+struct PlateReverbStages
+{
+    template <typename Reverb>
+    static void processInputChain (Reverb& reverb, const float* inputLeft, const float* inputRight, int numSamples)
+    {
+        auto* tankInput = reverb.blockBuffer.getWritePointer (Reverb::tankInputChannel);
+        reverb.processInputChain (inputLeft, inputRight, tankInput, tankInput, numSamples);
+    }
+
+    // both tank halves, they feed each other every sample so they can't be timed apart
+    template <typename Reverb>
+    static void processTank (Reverb& reverb, int numSamples)
+    {
+        auto* tankInput = reverb.blockBuffer.getReadPointer (Reverb::tankInputChannel);
+        reverb.template processTankSamples<false> (reverb.tanks[(size_t) PlateReverbQuality::full], tankInput, tankInput, numSamples);
+    }
+
+    template <typename Reverb>
+    static void gatherOutputTaps (Reverb& reverb, int numSamples)
+    {
+        reverb.gatherOutputTaps (reverb.tanks[(size_t) PlateReverbQuality::full],
+                                 reverb.blockBuffer.getWritePointer (Reverb::outputLeftChannel),
+                                 reverb.blockBuffer.getWritePointer (Reverb::outputRightChannel),
+                                 numSamples);
+    }
+};
+
+//==============================================================================
+namespace
+{
+    constexpr double sampleRate = 44100.0;
+    constexpr int numBenchmarkSamples = 1 << 22;
+
+    // keeps the optimiser from dropping the loops under test
+    volatile float sink = 0.0f;
+
+    // the sweep measures many more configurations, each one a little shorter
+    constexpr int numSweepSamples = 1 << 20;
+    constexpr double sweepSampleRates[] = { 44100.0, 48000.0, 96000.0, 192000.0 };
+    constexpr int sweepBlockSizes[] = { 1, 16, 64, 256, 1024, 4096 };
+
+    template <typename Function>
+    double measureNanosecondsPerSample (Function&& function, int numSamples = numBenchmarkSamples)
+    {
+        // warm up caches and branch predictors first
+        function (numSamples / 8);
+
+        auto start = Time::getHighResolutionTicks();
+        function (numSamples);
+        auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start);
+
+        return seconds * 1.0e9 / numSamples;
+    }
+
+    AudioBuffer<float> makeNoise (int numSamples)
+    {
+        AudioBuffer<float> noise (2, numSamples);
+        Random random (1);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                noise.setSample (channel, i, random.nextFloat() * 2.0f - 1.0f);
+
+        return noise;
+    }
+
+    /*  One modulated decay diffuser as the tank runs it: a reverse lattice
+        whose delay time swings by the full excursion around its length.
+    */
+    template <typename Interpolation>
+    double benchmarkModulatedLattice()
+    {
+        auto length = DattorroTopology::makeDelayNetwork (sampleRate).delaySamples[DattorroTopology::decayDiffusion1L];
+        auto excursion = (float) DattorroTopology::toSamples (DattorroTopology::maximumExcursionMilliseconds, sampleRate);
+
+        DelayLine<float, Interpolation> delayLine;
+        delayLine.prepareToPlay (length, (int) excursion + 4);
+
+        return measureNanosecondsPerSample ([&] (int numSamples)
+        {
+            float sample = 1.0f;
+            float phase = 0.0f;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                phase += 0.0001f;
+                auto delayInSamples = (float) length + excursion * (2.0f * (phase - std::floor (phase)) - 1.0f);
+
+                auto delayOutput = delayLine.getSample (delayInSamples);
+                auto delayInput = sample + delayOutput * 0.7f;
+                sample = delayOutput - delayInput * 0.7f;
+                delayLine.pushSample (delayInput);
+            }
+
+            sink = sample;
+        });
+    }
+
+    // the same lattice with a fixed integer delay, what an unmodulated line costs
+    double benchmarkFixedLattice()
+    {
+        auto length = DattorroTopology::makeDelayNetwork (sampleRate).delaySamples[DattorroTopology::decayDiffusion1L];
+
+        DelayLine<> delayLine;
+        delayLine.prepareToPlay (length);
+
+        return measureNanosecondsPerSample ([&] (int numSamples)
+        {
+            float sample = 1.0f;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto delayOutput = delayLine.getOutput();
+                auto delayInput = sample + delayOutput * 0.7f;
+                sample = delayOutput - delayInput * 0.7f;
+                delayLine.pushSample (delayInput);
+            }
+
+            sink = sample;
+        });
+    }
+
+    template <typename SampleType = float, typename TankType = SampleType, bool halfPrecisionDelays = false>
+    double benchmarkPlateReverb (float modulationDepth, bool silentInput = false,
+                                 PlateReverbQuality quality = PlateReverbQuality::full, bool trueStereo = false)
+    {
+        constexpr int blockSize = 512;
+
+        PlateReverb<SampleType, TankType, halfPrecisionDelays> reverb;
+        reverb.setModulationDepth (modulationDepth);
+        reverb.setQualityTiersEnabled (quality != PlateReverbQuality::full);
+        reverb.setQuality (quality);
+        reverb.setTrueStereoEnabled (trueStereo);
+        reverb.prepareToPlay (sampleRate, blockSize);
+
+        AudioBuffer<SampleType> input (2, blockSize);
+        AudioBuffer<SampleType> buffer (2, blockSize);
+        Random random (1);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < blockSize; ++i)
+                input.setSample (channel, i, silentInput ? SampleType (0) : SampleType (random.nextFloat() * 2.0f - 1.0f));
+
+        return measureNanosecondsPerSample ([&] (int numSamples)
+        {
+            // fresh input for every block, processing the output again would fade into denormals
+            for (int i = 0; i < numSamples; i += blockSize)
+            {
+                buffer.makeCopyOf (input, true);
+                reverb.processBlock (buffer, blockSize, 2);
+            }
+
+            sink = float (buffer.getSample (0, 0));
+        });
+    }
+
+    /*  512 sample blocks split every subBlockSize samples by parameter
+        changes that keep the values, what sample-accurate automation costs
+        before anything ramps. A subBlockSize of 512 gives the whole blocks.
+    */
+    double benchmarkSubBlocks (int subBlockSize)
+    {
+        constexpr int blockSize = 512;
+
+        PlateReverb<float> reverb;
+        reverb.prepareToPlay (sampleRate, blockSize);
+
+        std::vector<PlateReverbParameterChange> changes;
+
+        for (int offset = subBlockSize; offset < blockSize; offset += subBlockSize)
+            changes.push_back ({ offset, PlateReverbParameters() });
+
+        auto input = makeNoise (blockSize);
+        AudioBuffer<float> buffer (2, blockSize);
+
+        return measureNanosecondsPerSample ([&] (int numSamples)
+        {
+            for (int i = 0; i < numSamples; i += blockSize)
+            {
+                buffer.makeCopyOf (input, true);
+                reverb.processBlock (buffer, blockSize, 2, changes.data(), (int) changes.size());
+            }
+
+            sink = buffer.getSample (0, 0);
+        });
+    }
+
+    /*  Many instances sharing one core, each processing one block in turn as
+        a host does, so every block starts with the instance's state cold.
+    */
+    template <typename Reverb = PlateReverb<float>>
+    double benchmarkManyInstances (int numInstances)
+    {
+        constexpr int blockSize = 128;
+
+        std::vector<std::unique_ptr<Reverb>> reverbs;
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            reverbs.push_back (std::make_unique<Reverb>());
+            reverbs.back()->prepareToPlay (sampleRate, blockSize);
+        }
+
+        AudioBuffer<float> input (2, blockSize);
+        AudioBuffer<float> buffer (2, blockSize);
+        Random random (1);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < blockSize; ++i)
+                input.setSample (channel, i, random.nextFloat() * 2.0f - 1.0f);
+
+        return measureNanosecondsPerSample ([&] (int numSamples)
+        {
+            for (int i = 0, instance = 0; i < numSamples; i += blockSize, instance = (instance + 1) % numInstances)
+            {
+                buffer.makeCopyOf (input, true);
+                reverbs[(size_t) instance]->processBlock (buffer, blockSize, 2);
+            }
+
+            sink = buffer.getSample (0, 0);
+        });
+    }
+
+    /*  Every lane of one BatchedPlateReverb, each with its own block, in the
+        same ns per instance sample as benchmarkManyInstances, which runs
+        the same number of separate PlateReverb<float>s.
+    */
+    double benchmarkBatchedLanes()
+    {
+        constexpr int blockSize = 128;
+
+        BatchedPlateReverb reverb;
+        reverb.prepareToPlay (sampleRate, blockSize);
+
+        std::array<AudioBuffer<float>, BatchedPlateReverb::numLanes> buffers;
+        std::array<AudioBuffer<float>*, BatchedPlateReverb::numLanes> laneBuffers;
+
+        for (int lane = 0; lane < BatchedPlateReverb::numLanes; ++lane)
+        {
+            reverb.addLane();
+            buffers[(size_t) lane].setSize (2, blockSize);
+            laneBuffers[(size_t) lane] = &buffers[(size_t) lane];
+        }
+
+        auto input = makeNoise (blockSize);
+
+        return measureNanosecondsPerSample ([&] (int numSamples)
+        {
+            // one pass renders a block for every lane
+            for (int i = 0; i < numSamples; i += blockSize * BatchedPlateReverb::numLanes)
+            {
+                for (auto& buffer : buffers)
+                    buffer.makeCopyOf (input, true);
+
+                reverb.processBlock (laneBuffers.data(), blockSize);
+            }
+
+            sink = buffers[0].getSample (0, 0);
+        });
+    }
+
+    template <typename Reverb>
+    size_t getFootprintInBytes (double rate)
+    {
+        Reverb reverb;
+        reverb.prepareToPlay (rate, 512);
+        return reverb.getFootprintInBytes();
+    }
+
+    /*  Level of the difference half-precision storage makes to the wet
+        signal of a noise burst and its tail, relative to the wet signal.
+    */
+    double measureHalfPrecisionNoiseDecibels (float decay)
+    {
+        constexpr int blockSize = 512;
+        constexpr int numBlocks = int (sampleRate * 8.0) / blockSize;
+
+        PlateReverb<float> reference;
+        PlateReverb<float, float, true> reduced;
+
+        reference.setDecay (decay);
+        reference.setMix (1.0f);
+        reference.prepareToPlay (sampleRate, blockSize);
+        reduced.setDecay (decay);
+        reduced.setMix (1.0f);
+        reduced.prepareToPlay (sampleRate, blockSize);
+
+        AudioBuffer<float> referenceBuffer (2, blockSize);
+        AudioBuffer<float> reducedBuffer (2, blockSize);
+        Random random (1);
+        double signalEnergy = 0.0;
+        double errorEnergy = 0.0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            // half a second of noise, then the tail
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    referenceBuffer.setSample (channel, i, block * blockSize < int (sampleRate / 2) ? random.nextFloat() - 0.5f : 0.0f);
+
+            reducedBuffer.makeCopyOf (referenceBuffer, true);
+            reference.processBlock (referenceBuffer, blockSize, 2);
+            reduced.processBlock (reducedBuffer, blockSize, 2);
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    auto wanted = (double) referenceBuffer.getSample (channel, i);
+                    auto error = (double) reducedBuffer.getSample (channel, i) - wanted;
+                    signalEnergy += wanted * wanted;
+                    errorEnergy += error * error;
+                }
+            }
+        }
+
+        return 10.0 * std::log10 (errorEnergy / signalEnergy);
+    }
+
+    //==============================================================================
+    enum class Stage
+    {
+        inputChain,
+        tank,
+        outputTaps,
+        processBlock
+    };
+
+    const char* getStageName (Stage stage)
+    {
+        switch (stage)
+        {
+            case Stage::inputChain:   return "inputChain";
+            case Stage::tank:         return "tank";
+            case Stage::outputTaps:   return "outputTaps";
+            case Stage::processBlock: return "processBlock";
+        }
+
+        return "";
+    }
+
+    double benchmarkStage (Stage stage, double rate, int blockSize)
+    {
+        PlateReverb<float> reverb;
+        reverb.prepareToPlay (rate, blockSize);
+
+        auto input = makeNoise (blockSize);
+        AudioBuffer<float> buffer (2, blockSize);
+
+        // give the tank something to chew on
+        PlateReverbStages::processInputChain (reverb, input.getReadPointer (0), input.getReadPointer (1), blockSize);
+
+        return measureNanosecondsPerSample ([&] (int numSamples)
+        {
+            for (int i = 0; i < numSamples; i += blockSize)
+            {
+                switch (stage)
+                {
+                    case Stage::inputChain:
+                        PlateReverbStages::processInputChain (reverb, input.getReadPointer (0), input.getReadPointer (1), blockSize);
+                        break;
+
+                    case Stage::tank:
+                        PlateReverbStages::processTank (reverb, blockSize);
+                        break;
+
+                    case Stage::outputTaps:
+                        PlateReverbStages::gatherOutputTaps (reverb, blockSize);
+                        break;
+
+                    case Stage::processBlock:
+                        buffer.makeCopyOf (input, true);
+                        reverb.processBlock (buffer, blockSize, 2);
+                        break;
+                }
+            }
+
+            sink = buffer.getSample (0, 0);
+        }, numSweepSamples);
+    }
+
+    double benchmarkLegacyPlateReverb (double rate, int blockSize)
+    {
+        LegacyPlateReverb reverb;
+        reverb.prepareToPlay ((int) rate);
+
+        // its loop runs up to and including numSamples, so every call
+        // processes one sample more and needs one spare sample per channel
+        auto samplesPerCall = blockSize + 1;
+        auto input = makeNoise (samplesPerCall);
+        AudioBuffer<float> buffer (2, samplesPerCall);
+
+        return measureNanosecondsPerSample ([&] (int numSamples)
+        {
+            for (int i = 0; i < numSamples; i += samplesPerCall)
+            {
+                buffer.makeCopyOf (input, true);
+                reverb.processBlock (buffer, blockSize, 2);
+            }
+
+            sink = buffer.getSample (0, 0);
+        }, numSweepSamples);
+    }
+
+    double benchmarkJuceReverb (double rate, int blockSize)
+    {
+        dsp::Reverb reverb;
+        reverb.prepare ({ rate, (uint32) blockSize, 2 });
+
+        auto input = makeNoise (blockSize);
+        AudioBuffer<float> buffer (2, blockSize);
+
+        return measureNanosecondsPerSample ([&] (int numSamples)
+        {
+            for (int i = 0; i < numSamples; i += blockSize)
+            {
+                buffer.makeCopyOf (input, true);
+
+                dsp::AudioBlock<float> block (buffer);
+                reverb.process (dsp::ProcessContextReplacing<float> (block));
+            }
+
+            sink = buffer.getSample (0, 0);
+        }, numSweepSamples);
+    }
+
+    //==============================================================================
+    // collects every measurement as it is printed, for the JSON report
+    class Results
+    {
+    public:
+        void startSection (const String& title)
+        {
+            std::cout << std::endl << title << std::endl;
+            section = title;
+        }
+
+        void add (const String& name, double value, const String& unit = "ns/sample")
+        {
+            std::cout << ("  " + name).paddedRight (' ', 36) << String (value, 2) << " " << unit << std::endl;
+
+            auto* entry = new DynamicObject();
+            entry->setProperty ("section", section);
+            entry->setProperty ("name", name);
+            entry->setProperty ("value", value);
+            entry->setProperty ("unit", unit);
+            entries.add (var (entry));
+        }
+
+        // the sweep prints its own table
+        void addSweepPoint (const String& engine, Stage stage, double rate, int blockSize, double nanosecondsPerSample)
+        {
+            auto* entry = new DynamicObject();
+            entry->setProperty ("engine", engine);
+            entry->setProperty ("stage", getStageName (stage));
+            entry->setProperty ("sampleRate", rate);
+            entry->setProperty ("blockSize", blockSize);
+            entry->setProperty ("value", nanosecondsPerSample);
+            entry->setProperty ("unit", "ns/sample");
+            sweep.add (var (entry));
+        }
+
+        bool writeJson (const File& file) const
+        {
+            auto* root = new DynamicObject();
+            root->setProperty ("formatVersion", 1);
+            root->setProperty ("date", Time::getCurrentTime().toISO8601 (true));
+            root->setProperty ("cpu", SystemStats::getCpuModel());
+            root->setProperty ("results", entries);
+            root->setProperty ("sweep", sweep);
+
+            return file.replaceWithText (JSON::toString (var (root)));
+        }
+
+    private:
+        String section;
+        Array<var> entries;
+        Array<var> sweep;
+    };
+
+    /*  Every stage of PlateReverb<float> and the whole engine against the
+        legacy engine in Old/ and juce::dsp::Reverb, over the common host
+        sample rates and block sizes.
+    */
+    void runSweep (Results& results)
+    {
+        std::cout << std::endl << "Sweep, ns/sample. tank is both halves, which feed each other every sample" << std::endl;
+
+        for (auto rate : sweepSampleRates)
+        {
+            std::cout << std::endl << String (rate / 1000.0, 1).paddedRight (' ', 6) << "kHz  block"
+                      << "   input    tank    taps process  legacy     juce" << std::endl;
+
+            for (auto blockSize : sweepBlockSizes)
+            {
+                std::cout << String (blockSize).paddedLeft (' ', 15);
+
+                auto print = [] (double nanosecondsPerSample)
+                {
+                    std::cout << String (nanosecondsPerSample, 1).paddedLeft (' ', 8);
+                };
+
+                for (auto stage : { Stage::inputChain, Stage::tank, Stage::outputTaps, Stage::processBlock })
+                {
+                    auto result = benchmarkStage (stage, rate, blockSize);
+                    results.addSweepPoint ("PlateReverb<float>", stage, rate, blockSize, result);
+                    print (result);
+                }
+
+                auto legacy = benchmarkLegacyPlateReverb (rate, blockSize);
+                results.addSweepPoint ("Old/PlateReverb", Stage::processBlock, rate, blockSize, legacy);
+                print (legacy);
+
+                auto juceReverb = benchmarkJuceReverb (rate, blockSize);
+                results.addSweepPoint ("juce::dsp::Reverb", Stage::processBlock, rate, blockSize, juceReverb);
+                print (juceReverb);
+
+                std::cout << std::endl;
+            }
+        }
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // the plugin runs with denormals flushed, so measure that way too
+    ScopedNoDenormals noDenormals;
+
+    File jsonFile;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        String arg (argv[i]);
+
+        if (arg.startsWith ("--json="))
+        {
+            jsonFile = File::getCurrentWorkingDirectory().getChildFile (arg.fromFirstOccurrenceOf ("=", false, false));
+        }
+        else
+        {
+            std::cout << "Usage: PlateReverbBenchmark [--json=<results.json>]" << std::endl;
+            return 1;
+        }
+    }
+
+    Results results;
+
+    results.startSection ("Modulated decay diffuser, interpolation policy cost at " + String (sampleRate, 0) + " Hz");
+
+    results.add ("fixed delay (unmodulated)", benchmarkFixedLattice());
+    results.add ("none", benchmarkModulatedLattice<DelayInterpolation::None>());
+    results.add ("linear", benchmarkModulatedLattice<DelayInterpolation::Linear>());
+    results.add ("cubic", benchmarkModulatedLattice<DelayInterpolation::Cubic>());
+    results.add ("allpass", benchmarkModulatedLattice<DelayInterpolation::Allpass>());
+
+    results.startSection ("PlateReverb::processBlock, 512 sample blocks");
+
+    results.add ("modulation off", benchmarkPlateReverb (0.0f));
+    results.add ("modulation on", benchmarkPlateReverb (1.0f));
+    results.add ("silent input, tank asleep", benchmarkPlateReverb (0.0f, true));
+
+    results.startSection ("Sample-accurate automation, 512 sample blocks split at parameter changes");
+
+    auto wholeBlocks = benchmarkSubBlocks (512);
+    results.add ("whole blocks", wholeBlocks);
+
+    for (auto subBlockSize : { 64, 32, 16 })
+    {
+        auto split = benchmarkSubBlocks (subBlockSize);
+        results.add ("split every " + String (subBlockSize), split);
+        results.add ("split every " + String (subBlockSize) + ", overhead", 100.0 * (split / wholeBlocks - 1.0), "%");
+    }
+
+    results.startSection ("Instances sharing a core, 128 sample blocks");
+
+    results.add ("footprint per instance", (double) getFootprintInBytes<PlateReverb<float>> (sampleRate) / 1024.0, "KiB");
+    results.add ("1 instance", benchmarkManyInstances (1));
+    results.add ("16 instances", benchmarkManyInstances (16));
+    results.add ("64 instances", benchmarkManyInstances (64));
+
+    results.startSection ("One instance per SIMD lane, 128 sample blocks");
+
+    auto numLanesName = String (BatchedPlateReverb::numLanes);
+    results.add (numLanesName + " PlateReverb<float> instances", benchmarkManyInstances (BatchedPlateReverb::numLanes));
+    results.add (numLanesName + " BatchedPlateReverb lanes", benchmarkBatchedLanes());
+
+    results.startSection ("Engine precision, modulation off");
+
+    results.add ("float", benchmarkPlateReverb<float> (0.0f));
+    results.add ("float I/O, double tank", benchmarkPlateReverb<float, double> (0.0f));
+    results.add ("double", benchmarkPlateReverb<double> (0.0f));
+
+    results.startSection ("Predelay and long tank delay storage, modulation off");
+
+    results.add ("float", benchmarkPlateReverb<float> (0.0f));
+    results.add ("half", benchmarkPlateReverb<float, float, true> (0.0f));
+    results.add ("float, 64 instances", benchmarkManyInstances (64));
+    results.add ("half, 64 instances", benchmarkManyInstances<PlateReverb<float, float, true>> (64));
+
+    for (auto rate : { 48000.0, 192000.0 })
+    {
+        auto rateName = String (rate / 1000.0, 0) + " kHz";
+        results.add ("footprint at " + rateName + ", float", (double) getFootprintInBytes<PlateReverb<float>> (rate) / 1024.0, "KiB");
+        results.add ("footprint at " + rateName + ", half", (double) getFootprintInBytes<PlateReverb<float, float, true>> (rate) / 1024.0, "KiB");
+    }
+
+    // relative to the wet signal
+    for (auto decay : { 0.5f, 0.9f })
+        results.add ("half storage error, decay " + String (decay, 1), measureHalfPrecisionNoiseDecibels (decay), "dB");
+
+    results.startSection ("Input chains, modulation off");
+
+    results.add ("mono sum", benchmarkPlateReverb<float> (0.0f));
+    results.add ("true stereo", benchmarkPlateReverb<float> (0.0f, false, PlateReverbQuality::full, true));
+
+    results.startSection ("Quality tiers, modulation on");
+
+    results.add ("full", benchmarkPlateReverb<float> (1.0f));
+    results.add ("eco, half-rate tank", benchmarkPlateReverb<float> (1.0f, false, PlateReverbQuality::eco));
+
+    runSweep (results);
+
+    if (jsonFile != File())
+    {
+        if (! results.writeJson (jsonFile))
+        {
+            std::cerr << "Couldn't write " << jsonFile.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        std::cout << std::endl << "Results written to " << jsonFile.getFullPathName() << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,976 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Numerical equivalence test for the plate reverb engine.
+
+    Renders impulses, noise and sine sweeps, with and without random
+    parameter automation, through every PlateReverb configuration and
+    through the frozen copy in Reference/, then compares the two outputs.
+    The engines under test get the automation sample-accurately as lists of
+    parameter changes, the reference by splitting the host blocks.
+    BatchedPlateReverb has no frozen copy, one of its lanes is compared
+    with PlateReverb<float> instead. The modes Reference/ doesn't cover, the
+    eco tier, tier switches, true stereo and sleeping, are checked against
+    the engine's own default path.
+    Exits with 1 if any comparison is outside the tolerances, so it can
+    gate changes to Source/Reverb.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include <functional>
+#include "../../../Source/Reverb/PlateReverb.h"
+#include "../../../Source/Reverb/BatchedPlateReverb.h"
+#include "../../../Reference/PlateReverb.h"
+
+//==============================================================================
+namespace
+{
+    struct Tolerances
+    {
+        double maxAbsoluteError = 1.0e-4;
+
+        // peak error relative to the reference's peak
+        double maxErrorDecibels = -80.0;
+
+        // largest difference in any bin of the long-term average spectrum
+        double maxSpectralDeviationDecibels = 0.1;
+    };
+
+    struct TestSettings
+    {
+        double sampleRate = 48000.0;
+        double seconds = 4.0;
+        int maximumBlockSize = 512;
+        int seed = 1;
+        String engineFilter;
+        Tolerances tolerances;
+    };
+
+    enum class Signal
+    {
+        impulse,
+        noise,
+        sweep
+    };
+
+    const char* getSignalName (Signal signal)
+    {
+        switch (signal)
+        {
+            case Signal::impulse: return "impulse";
+            case Signal::noise:   return "noise";
+            case Signal::sweep:   return "sweep";
+        }
+
+        return "";
+    }
+
+    // a parameter snapshot the engines receive at exactly this sample
+    struct AutomationEvent
+    {
+        int position;
+        PlateReverbParameters parameters;
+    };
+
+    // everything both engines get fed, so they see identical input, block sizes and automation
+    struct RenderJob
+    {
+        double sampleRate;
+        int maximumBlockSize;
+        AudioBuffer<double> input;
+        Array<int> blockSizes;
+        Array<AutomationEvent> automation;
+    };
+
+    struct Comparison
+    {
+        double maxAbsoluteError = 0.0;
+        double errorDecibels = 0.0;
+        double spectralDeviationDecibels = 0.0;
+
+        bool passes (const Tolerances& tolerances) const
+        {
+            return maxAbsoluteError <= tolerances.maxAbsoluteError
+                && errorDecibels <= tolerances.maxErrorDecibels
+                && spectralDeviationDecibels <= tolerances.maxSpectralDeviationDecibels;
+        }
+    };
+
+    constexpr double silenceDecibels = -200.0;
+
+    // limits for the behaviour checks, a margin above what the engine measures at 44.1 to 96 kHz
+    constexpr double ecoBandDeviationDecibels = 1.0;
+    constexpr double ecoRolloffDecibels = -18.0;
+    constexpr double tierFadeCorrelation = 0.85;
+    constexpr double tierTailDeviationDecibels = 3.0;
+    constexpr double trueStereoMaximumError = 1.0e-6;
+    constexpr double wakeFromSleepMaximumError = 1.5e-7;
+
+    // how much of the tail after a tier switch the level check looks at
+    constexpr double tierSwitchTailSeconds = 1.0;
+
+    // each burst of the sleep check and the silence after it
+    constexpr double sleepTestPeriodSeconds = 4.0;
+
+    //==============================================================================
+    // the excitation rings for the first half, the second half leaves the tail on its own
+    AudioBuffer<double> makeSignal (Signal signal, double sampleRate, int numSamples, int seed)
+    {
+        AudioBuffer<double> input (2, numSamples);
+        input.clear();
+
+        auto excitationLength = numSamples / 2;
+
+        switch (signal)
+        {
+            case Signal::impulse:
+                // left only, so the dry path tells the channels apart
+                input.setSample (0, 0, 1.0);
+                break;
+
+            case Signal::noise:
+            {
+                Random random (seed);
+
+                for (int channel = 0; channel < 2; ++channel)
+                    for (int i = 0; i < excitationLength; ++i)
+                        input.setSample (channel, i, (random.nextDouble() * 2.0 - 1.0) * 0.5);
+
+                break;
+            }
+
+            case Signal::sweep:
+            {
+                // exponential sine sweep from 20 Hz up to 20 kHz or just below Nyquist
+                auto startFrequency = 20.0;
+                auto endFrequency = jmin (20000.0, sampleRate * 0.45);
+                auto duration = excitationLength / sampleRate;
+                auto rate = std::log (endFrequency / startFrequency);
+
+                for (int i = 0; i < excitationLength; ++i)
+                {
+                    auto t = i / sampleRate;
+                    auto phase = MathConstants<double>::twoPi * startFrequency * duration / rate
+                               * (std::exp (t / duration * rate) - 1.0);
+                    auto sample = 0.5 * std::sin (phase);
+
+                    input.setSample (0, i, sample);
+                    input.setSample (1, i, sample);
+                }
+
+                break;
+            }
+        }
+
+        return input;
+    }
+
+    // a fresh random snapshot of all ten parameters every 50 to 400 ms, over the whole range the plugin allows
+    Array<AutomationEvent> makeAutomation (double sampleRate, int numSamples, int seed)
+    {
+        Array<AutomationEvent> automation;
+        Random random (seed);
+
+        auto minimumInterval = (int) (0.05 * sampleRate);
+        auto maximumInterval = (int) (0.4 * sampleRate);
+
+        for (int position = 0; position < numSamples; position += minimumInterval + random.nextInt (maximumInterval - minimumInterval))
+        {
+            PlateReverbParameters parameters;
+            parameters.predelayTime = random.nextFloat() * 200.0f;
+            parameters.decay = random.nextFloat();
+            parameters.decayDiffusion1 = random.nextFloat();
+            parameters.inputDiffusion1 = random.nextFloat();
+            parameters.inputDiffusion2 = random.nextFloat();
+            parameters.bandwidth = random.nextFloat();
+            parameters.damping = random.nextFloat();
+            parameters.mix = random.nextFloat();
+            parameters.modulationRate = 0.1f + random.nextFloat() * 4.9f;
+            parameters.modulationDepth = random.nextFloat();
+
+            automation.add ({ position, parameters });
+        }
+
+        return automation;
+    }
+
+    // hosts don't promise full blocks, so the block size changes randomly from one block to the next
+    Array<int> makeBlockSizes (int numSamples, int maximumBlockSize, int seed)
+    {
+        Array<int> blockSizes;
+        Random random (seed);
+
+        for (int position = 0; position < numSamples;)
+        {
+            auto blockSize = jmin (1 + random.nextInt (maximumBlockSize), numSamples - position);
+            blockSizes.add (blockSize);
+            position += blockSize;
+        }
+
+        return blockSizes;
+    }
+
+    //==============================================================================
+    template <typename Target, typename Source>
+    Target convertParameters (const Source& source)
+    {
+        Target target;
+        target.predelayTime = source.predelayTime;
+        target.decay = source.decay;
+        target.decayDiffusion1 = source.decayDiffusion1;
+        target.inputDiffusion1 = source.inputDiffusion1;
+        target.inputDiffusion2 = source.inputDiffusion2;
+        target.bandwidth = source.bandwidth;
+        target.damping = source.damping;
+        target.mix = source.mix;
+        target.modulationRate = source.modulationRate;
+        target.modulationDepth = source.modulationDepth;
+        return target;
+    }
+
+    /*  Plays the job through a fresh engine in the job's host blocks. The
+        reference gets the automation by splitting blocks at every event,
+        the engine under test as a list of changes with each block instead.
+    */
+    template <typename SampleType, typename Engine, bool withParameterChanges>
+    AudioBuffer<double> render (const RenderJob& job)
+    {
+        Engine engine;
+        engine.prepareToPlay (job.sampleRate, job.maximumBlockSize);
+
+        auto numSamples = job.input.getNumSamples();
+        AudioBuffer<double> output (2, numSamples);
+        AudioBuffer<SampleType> block (2, job.maximumBlockSize);
+
+        std::vector<PlateReverbParameterChange> changes;
+        changes.reserve ((size_t) job.automation.size());
+
+        auto process = [&] (int position, int count, const PlateReverbParameterChange* blockChanges, int numChanges)
+        {
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < count; ++i)
+                    block.setSample (channel, i, (SampleType) job.input.getSample (channel, position + i));
+
+            if constexpr (withParameterChanges)
+                engine.processBlock (block, count, 2, blockChanges, numChanges);
+            else
+                engine.processBlock (block, count, 2);
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < count; ++i)
+                    output.setSample (channel, position + i, (double) block.getSample (channel, i));
+        };
+
+        int position = 0;
+        int nextEvent = 0;
+
+        for (auto blockSize : job.blockSizes)
+        {
+            auto blockEnd = position + blockSize;
+
+            if constexpr (withParameterChanges)
+            {
+                changes.clear();
+
+                for (; nextEvent < job.automation.size() && job.automation.getReference (nextEvent).position < blockEnd; ++nextEvent)
+                {
+                    auto& event = job.automation.getReference (nextEvent);
+                    changes.push_back ({ event.position - position, event.parameters });
+                }
+
+                process (position, blockSize, changes.data(), (int) changes.size());
+                position = blockEnd;
+            }
+            else
+            {
+                // split blocks at automation events so they land on the same sample as in the engine under test
+                while (position < blockEnd)
+                {
+                    while (nextEvent < job.automation.size() && job.automation.getReference (nextEvent).position <= position)
+                        engine.setParameters (convertParameters<typename Engine::Parameters> (job.automation.getReference (nextEvent++).parameters));
+
+                    auto end = blockEnd;
+
+                    if (nextEvent < job.automation.size())
+                        end = jmin (end, job.automation.getReference (nextEvent).position);
+
+                    process (position, end - position, nullptr, 0);
+                    position = end;
+                }
+            }
+        }
+
+        return output;
+    }
+
+    /*  Plays the job through lane 0 of a BatchedPlateReverb, splitting blocks at
+        automation events like the reference. The other lanes run settings of
+        their own on scaled copies of the input, none of which may reach lane 0.
+    */
+    AudioBuffer<double> renderBatchedLane (const RenderJob& job)
+    {
+        BatchedPlateReverb engine;
+        std::vector<AudioBuffer<float>> blocks;
+
+        // configured before prepareToPlay, so the other lanes start at their settings without ramping
+        for (int lane = 0; lane < BatchedPlateReverb::numLanes; ++lane)
+        {
+            engine.addLane();
+            blocks.emplace_back (2, job.maximumBlockSize);
+
+            if (lane == 0)
+                continue;
+
+            PlateReverbParameters parameters;
+            parameters.predelayTime = 30.0f * (float) lane;
+            parameters.decay = 0.4f + 0.1f * (float) lane;
+            parameters.damping = 0.2f;
+            parameters.mix = 0.8f;
+            parameters.modulationRate = 0.5f * (float) lane;
+            parameters.modulationDepth = 0.3f;
+            engine.setParameters (lane, parameters);
+        }
+
+        engine.prepareToPlay (job.sampleRate, job.maximumBlockSize);
+
+        auto numSamples = job.input.getNumSamples();
+        AudioBuffer<double> output (2, numSamples);
+
+        std::vector<AudioBuffer<float>*> laneBuffers;
+
+        for (auto& block : blocks)
+            laneBuffers.push_back (&block);
+
+        auto process = [&] (int position, int count)
+        {
+            for (int lane = 0; lane < BatchedPlateReverb::numLanes; ++lane)
+            {
+                auto gain = 1.0 / (lane + 1);
+
+                for (int channel = 0; channel < 2; ++channel)
+                    for (int i = 0; i < count; ++i)
+                        blocks[(size_t) lane].setSample (channel, i, (float) (job.input.getSample (channel, position + i) * gain));
+            }
+
+            engine.processBlock (laneBuffers.data(), count);
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < count; ++i)
+                    output.setSample (channel, position + i, (double) blocks[0].getSample (channel, i));
+        };
+
+        int position = 0;
+        int nextEvent = 0;
+
+        for (auto blockSize : job.blockSizes)
+        {
+            auto blockEnd = position + blockSize;
+
+            while (position < blockEnd)
+            {
+                while (nextEvent < job.automation.size() && job.automation.getReference (nextEvent).position <= position)
+                    engine.setParameters (0, job.automation.getReference (nextEvent++).parameters);
+
+                auto end = blockEnd;
+
+                if (nextEvent < job.automation.size())
+                    end = jmin (end, job.automation.getReference (nextEvent).position);
+
+                process (position, end - position);
+                position = end;
+            }
+        }
+
+        return output;
+    }
+
+    //==============================================================================
+    // Welch estimate of one channel's power spectrum, Hann windows with 50% overlap
+    std::vector<double> getAverageSpectrum (const AudioBuffer<double>& buffer, int channel)
+    {
+        constexpr int fftOrder = 12;
+        constexpr int fftSize = 1 << fftOrder;
+
+        dsp::FFT fft (fftOrder);
+        dsp::WindowingFunction<float> window ((size_t) fftSize, dsp::WindowingFunction<float>::hann, false);
+
+        std::vector<float> frame ((size_t) fftSize * 2);
+        std::vector<double> spectrum ((size_t) fftSize / 2 + 1, 0.0);
+
+        for (int start = 0; start + fftSize <= buffer.getNumSamples(); start += fftSize / 2)
+        {
+            std::fill (frame.begin(), frame.end(), 0.0f);
+
+            for (int i = 0; i < fftSize; ++i)
+                frame[(size_t) i] = (float) buffer.getSample (channel, start + i);
+
+            window.multiplyWithWindowingTable (frame.data(), (size_t) fftSize);
+            fft.performFrequencyOnlyForwardTransform (frame.data());
+
+            for (size_t bin = 0; bin < spectrum.size(); ++bin)
+                spectrum[bin] += (double) frame[bin] * (double) frame[bin];
+        }
+
+        return spectrum;
+    }
+
+    // bins more than 90 dB below the loudest one are left out, their level is mostly rounding noise
+    double getSpectralDeviationDecibels (const AudioBuffer<double>& reference, const AudioBuffer<double>& output)
+    {
+        constexpr double floorDecibels = -90.0;
+
+        double deviation = 0.0;
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            auto referenceSpectrum = getAverageSpectrum (reference, channel);
+            auto outputSpectrum = getAverageSpectrum (output, channel);
+
+            auto loudest = *std::max_element (referenceSpectrum.begin(), referenceSpectrum.end());
+            auto floor = loudest * std::pow (10.0, floorDecibels / 10.0);
+
+            for (size_t bin = 0; bin < referenceSpectrum.size(); ++bin)
+            {
+                if (referenceSpectrum[bin] <= floor || referenceSpectrum[bin] <= 0.0)
+                    continue;
+
+                auto ratio = jmax (outputSpectrum[bin], std::numeric_limits<double>::min()) / referenceSpectrum[bin];
+                deviation = jmax (deviation, std::abs (10.0 * std::log10 (ratio)));
+            }
+        }
+
+        return deviation;
+    }
+
+    Comparison compare (const AudioBuffer<double>& reference, const AudioBuffer<double>& output)
+    {
+        Comparison comparison;
+        double referencePeak = 0.0;
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            for (int i = 0; i < reference.getNumSamples(); ++i)
+            {
+                auto expected = reference.getSample (channel, i);
+                auto error = std::abs (output.getSample (channel, i) - expected);
+
+                // NaN never compares greater, so catch it explicitly
+                if (std::isnan (error))
+                    error = std::numeric_limits<double>::infinity();
+
+                comparison.maxAbsoluteError = jmax (comparison.maxAbsoluteError, error);
+                referencePeak = jmax (referencePeak, std::abs (expected));
+            }
+        }
+
+        comparison.errorDecibels = referencePeak > 0.0
+                                 ? Decibels::gainToDecibels (comparison.maxAbsoluteError / referencePeak, silenceDecibels)
+                                 : silenceDecibels;
+        comparison.spectralDeviationDecibels = getSpectralDeviationDecibels (reference, output);
+
+        return comparison;
+    }
+
+    //==============================================================================
+    // an engine configuration and the reference configuration it has to match
+    struct EngineUnderTest
+    {
+        String name;
+        std::function<AudioBuffer<double> (const RenderJob&)> renderEngine;
+        std::function<AudioBuffer<double> (const RenderJob&)> renderReference;
+    };
+
+    template <typename SampleType, typename TankType = SampleType, bool halfPrecisionDelays = false>
+    EngineUnderTest makeEngineUnderTest (const String& name)
+    {
+        return { name,
+                 render<SampleType, PlateReverb<SampleType, TankType, halfPrecisionDelays>, true>,
+                 render<SampleType, Reference::PlateReverb<SampleType, TankType, halfPrecisionDelays>, false> };
+    }
+
+    std::vector<EngineUnderTest> getEnginesUnderTest()
+    {
+        return { makeEngineUnderTest<float> ("PlateReverb<float>"),
+                 makeEngineUnderTest<double> ("PlateReverb<double>"),
+                 makeEngineUnderTest<float, double> ("PlateReverb<float, double>"),
+                 makeEngineUnderTest<float, float, true> ("PlateReverb<float, float, true>"),
+                 makeEngineUnderTest<float, double, true> ("PlateReverb<float, double, true>"),
+                 { "BatchedPlateReverb, lane 0 against PlateReverb<float>",
+                   renderBatchedLane,
+                   render<float, PlateReverb<float>, false> } };
+    }
+
+    //==============================================================================
+    /*  Plays input through an engine that is already set up and prepared, in
+        blocks of blockSize. beforeBlock is called with the start of every
+        block, e.g. to change a setting at a given sample.
+    */
+    template <typename SampleType, typename Engine>
+    AudioBuffer<double> renderThrough (Engine& engine, const AudioBuffer<double>& input, int blockSize,
+                                       const std::function<void (int)>& beforeBlock = {})
+    {
+        auto numSamples = input.getNumSamples();
+        AudioBuffer<double> output (2, numSamples);
+        AudioBuffer<SampleType> block (2, blockSize);
+
+        for (int position = 0; position < numSamples; position += blockSize)
+        {
+            auto count = jmin (blockSize, numSamples - position);
+
+            if (beforeBlock)
+                beforeBlock (position);
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < count; ++i)
+                    block.setSample (channel, i, (SampleType) input.getSample (channel, position + i));
+
+            engine.processBlock (block, count, 2);
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < count; ++i)
+                    output.setSample (channel, position + i, (double) block.getSample (channel, i));
+        }
+
+        return output;
+    }
+
+    // a PlateReverb<float> set up by configure and prepared. wet only, so the dry signal doesn't hide differences in the tail
+    std::unique_ptr<PlateReverb<float>> makeWetEngine (const TestSettings& settings, const std::function<void (PlateReverb<float>&)>& configure = {})
+    {
+        auto engine = std::make_unique<PlateReverb<float>>();
+
+        PlateReverbParameters parameters;
+        parameters.mix = 1.0f;
+        engine->setParameters (parameters);
+
+        if (configure)
+            configure (*engine);
+
+        engine->prepareToPlay (settings.sampleRate, settings.maximumBlockSize);
+        return engine;
+    }
+
+    // power of both channels' average spectra between two frequencies, in dB
+    double getBandLevel (const std::vector<double>& left, const std::vector<double>& right, double sampleRate, double low, double high)
+    {
+        auto binWidth = sampleRate / (double) (2 * (left.size() - 1));
+        double power = 0.0;
+
+        for (auto bin = (size_t) std::ceil (low / binWidth); bin < left.size() && (double) bin * binWidth < high; ++bin)
+            power += left[bin] + right[bin];
+
+        return 10.0 * std::log10 (jmax (power, std::numeric_limits<double>::min()));
+    }
+
+    // largest level difference in any third-octave band from 100 Hz up to highestFrequency
+    double getBandDeviationDecibels (const AudioBuffer<double>& reference, const AudioBuffer<double>& output,
+                                     double sampleRate, double highestFrequency)
+    {
+        auto referenceLeft = getAverageSpectrum (reference, 0);
+        auto referenceRight = getAverageSpectrum (reference, 1);
+        auto outputLeft = getAverageSpectrum (output, 0);
+        auto outputRight = getAverageSpectrum (output, 1);
+
+        auto bandRatio = std::pow (2.0, 1.0 / 3.0);
+        double deviation = 0.0;
+
+        for (auto low = 100.0; low < highestFrequency; low *= bandRatio)
+        {
+            auto high = jmin (highestFrequency, low * bandRatio);
+            deviation = jmax (deviation, std::abs (getBandLevel (outputLeft, outputRight, sampleRate, low, high)
+                                                   - getBandLevel (referenceLeft, referenceRight, sampleRate, low, high)));
+        }
+
+        return deviation;
+    }
+
+    // normalised cross-correlation at zero lag of both channels over [start, end)
+    double getCorrelation (const AudioBuffer<double>& a, const AudioBuffer<double>& b, int start, int end)
+    {
+        double product = 0.0, powerA = 0.0, powerB = 0.0;
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            for (int i = start; i < end; ++i)
+            {
+                product += a.getSample (channel, i) * b.getSample (channel, i);
+                powerA += a.getSample (channel, i) * a.getSample (channel, i);
+                powerB += b.getSample (channel, i) * b.getSample (channel, i);
+            }
+        }
+
+        return powerA > 0.0 && powerB > 0.0 ? product / std::sqrt (powerA * powerB) : 0.0;
+    }
+
+    double getMaximumAbsoluteError (const AudioBuffer<double>& reference, const AudioBuffer<double>& output)
+    {
+        double error = 0.0;
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < reference.getNumSamples(); ++i)
+                error = jmax (error, std::abs (output.getSample (channel, i) - reference.getSample (channel, i)));
+
+        return error;
+    }
+
+    //==============================================================================
+    // the eco tier against the full one on noise. below a sixth of the rate the tail should keep its colour
+    double measureEcoBandDeviation (const TestSettings& settings)
+    {
+        auto input = makeSignal (Signal::noise, settings.sampleRate, (int) (settings.seconds * settings.sampleRate), settings.seed);
+
+        auto full = makeWetEngine (settings);
+        auto eco = makeWetEngine (settings, [] (auto& engine) { engine.setQualityTiersEnabled (true);
+                                                                engine.setQuality (PlateReverbQuality::eco); });
+
+        return getBandDeviationDecibels (renderThrough<float> (*full, input, settings.maximumBlockSize),
+                                         renderThrough<float> (*eco, input, settings.maximumBlockSize),
+                                         settings.sampleRate, settings.sampleRate / 6.0);
+    }
+
+    // how far the eco tier's tail lies below the full tier's above a quarter of the rate, where the half-band filters cut
+    double measureEcoRolloff (const TestSettings& settings)
+    {
+        auto input = makeSignal (Signal::noise, settings.sampleRate, (int) (settings.seconds * settings.sampleRate), settings.seed);
+
+        auto full = makeWetEngine (settings);
+        auto eco = makeWetEngine (settings, [] (auto& engine) { engine.setQualityTiersEnabled (true);
+                                                                engine.setQuality (PlateReverbQuality::eco); });
+
+        auto fullOutput = renderThrough<float> (*full, input, settings.maximumBlockSize);
+        auto ecoOutput = renderThrough<float> (*eco, input, settings.maximumBlockSize);
+
+        auto low = settings.sampleRate / 4.0;
+        auto high = settings.sampleRate / 2.0;
+
+        return getBandLevel (getAverageSpectrum (ecoOutput, 0), getAverageSpectrum (ecoOutput, 1), settings.sampleRate, low, high)
+             - getBandLevel (getAverageSpectrum (fullOutput, 0), getAverageSpectrum (fullOutput, 1), settings.sampleRate, low, high);
+    }
+
+    // the part of a render from start on, numSamples long
+    AudioBuffer<double> getSegment (const AudioBuffer<double>& buffer, int start, int numSamples)
+    {
+        AudioBuffer<double> segment (2, numSamples);
+
+        for (int channel = 0; channel < 2; ++channel)
+            segment.copyFrom (channel, 0, buffer, channel, start, numSamples);
+
+        return segment;
+    }
+
+    /*  Switches the tier 100 ms into the tail, one engine from each tier's
+        unswitched render. The two tiers' tails are different waveforms, so
+        while the fade runs the output has to follow the tier it leaves,
+        and afterwards sound like the tier it went to.
+    */
+    struct TierSwitch
+    {
+        AudioBuffer<double> from, to, switched;
+        int switchPosition, tailEnd;
+    };
+
+    TierSwitch renderTierSwitch (const TestSettings& settings, PlateReverbQuality from, PlateReverbQuality to)
+    {
+        auto numSamples = (int) (settings.seconds * settings.sampleRate);
+        auto input = makeSignal (Signal::noise, settings.sampleRate, numSamples, settings.seed);
+
+        auto makeTierEngine = [&] (PlateReverbQuality quality)
+        {
+            return makeWetEngine (settings, [quality] (PlateReverb<float>& engine) { engine.setQualityTiersEnabled (true);
+                                                                                     engine.setQuality (quality); });
+        };
+
+        auto fromEngine = makeTierEngine (from);
+        auto toEngine = makeTierEngine (to);
+        auto switchedEngine = makeTierEngine (from);
+
+        TierSwitch result;
+        result.switchPosition = numSamples / 2 + (int) (0.1 * settings.sampleRate);
+        result.tailEnd = jmin (numSamples, result.switchPosition + (int) (tierSwitchTailSeconds * settings.sampleRate));
+
+        result.from = renderThrough<float> (*fromEngine, input, settings.maximumBlockSize);
+        result.to = renderThrough<float> (*toEngine, input, settings.maximumBlockSize);
+        result.switched = renderThrough<float> (*switchedEngine, input, settings.maximumBlockSize, [&] (int position)
+        {
+            if (position >= result.switchPosition)
+                switchedEngine->setQuality (to);
+        });
+
+        return result;
+    }
+
+    // correlation with the tier being left over the 50 ms fade, a tail handed over out of place would break it
+    double measureTierFadeCorrelation (const TestSettings& settings, PlateReverbQuality from, PlateReverbQuality to)
+    {
+        auto render = renderTierSwitch (settings, from, to);
+        auto fadeEnd = render.switchPosition + (int) (0.05 * settings.sampleRate);
+
+        return getCorrelation (render.from, render.switched, render.switchPosition, fadeEnd);
+    }
+
+    // third-octave levels below a sixth of the rate once the fade is over, against the tier switched to. a tail lost in the handover would fail it
+    double measureTierTailDeviation (const TestSettings& settings, PlateReverbQuality from, PlateReverbQuality to)
+    {
+        auto render = renderTierSwitch (settings, from, to);
+        auto tailStart = render.switchPosition + (int) (0.05 * settings.sampleRate);
+        auto tailLength = render.tailEnd - tailStart;
+
+        return getBandDeviationDecibels (getSegment (render.to, tailStart, tailLength),
+                                         getSegment (render.switched, tailStart, tailLength),
+                                         settings.sampleRate, settings.sampleRate / 6.0);
+    }
+
+    // true stereo fed the same signal on both sides has to sound like the mono input chain
+    double measureTrueStereoAgainstMono (const TestSettings& settings)
+    {
+        auto numSamples = (int) (settings.seconds * settings.sampleRate);
+        double error = 0.0;
+
+        for (auto signal : { Signal::noise, Signal::sweep })
+        {
+            auto input = makeSignal (signal, settings.sampleRate, numSamples, settings.seed);
+            input.copyFrom (1, 0, input, 0, 0, numSamples);
+
+            auto mono = makeWetEngine (settings);
+            auto trueStereo = makeWetEngine (settings, [] (auto& engine) { engine.setTrueStereoEnabled (true); });
+
+            error = jmax (error, getMaximumAbsoluteError (renderThrough<float> (*mono, input, settings.maximumBlockSize),
+                                                          renderThrough<float> (*trueStereo, input, settings.maximumBlockSize)));
+        }
+
+        return error;
+    }
+
+    /*  Bursts of noise with long enough silence between them for the engine
+        to fall asleep, against one whose threshold is too low to ever let it.
+        Infinite if either engine didn't behave that way, as then nothing
+        was tested.
+    */
+    double measureWakeFromSleep (const TestSettings& settings)
+    {
+        auto burstSamples = (int) (0.25 * settings.sampleRate);
+        auto period = (int) (sleepTestPeriodSeconds * settings.sampleRate);
+        auto numSamples = 3 * period;
+
+        AudioBuffer<double> input (2, numSamples);
+        input.clear();
+
+        Random random (settings.seed);
+
+        for (int burst = 0; burst < 3; ++burst)
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < burstSamples; ++i)
+                    input.setSample (channel, burst * period + i, (random.nextDouble() * 2.0 - 1.0) * 0.5);
+
+        auto sleeping = makeWetEngine (settings);
+        auto awake = makeWetEngine (settings, [] (auto& engine) { engine.setSilenceThreshold (-180.0f); });
+
+        int numSleepingBlocks = 0;
+        int numBlocksAwakeOneSlept = 0;
+
+        auto reference = renderThrough<float> (*awake, input, settings.maximumBlockSize, [&] (int position)
+        {
+            if (position > burstSamples && awake->isSleeping())
+                ++numBlocksAwakeOneSlept;
+        });
+
+        auto output = renderThrough<float> (*sleeping, input, settings.maximumBlockSize, [&] (int)
+        {
+            if (sleeping->isSleeping())
+                ++numSleepingBlocks;
+        });
+
+        if (numSleepingBlocks == 0 || numBlocksAwakeOneSlept > 0)
+            return std::numeric_limits<double>::infinity();
+
+        return getMaximumAbsoluteError (reference, output);
+    }
+
+    // a property of a mode Reference/ doesn't cover, measured against the engine's own default path
+    struct BehaviourCheck
+    {
+        String name;
+        std::function<double (const TestSettings&)> measure;
+        double limit;
+
+        // true if the value has to reach the limit, like a correlation, false if it may not exceed it
+        bool isMinimum;
+
+        bool passes (double value) const { return isMinimum ? value >= limit : value <= limit; }
+    };
+
+    std::vector<BehaviourCheck> getBehaviourChecks()
+    {
+        return { { "Eco tier: third-octave level difference to full below rate / 6 (dB)",
+                   measureEcoBandDeviation, ecoBandDeviationDecibels, false },
+                 { "Eco tier: level above rate / 4 relative to full (dB)",
+                   measureEcoRolloff, ecoRolloffDecibels, false },
+                 { "Full to eco switch: correlation with the full tier during the fade",
+                   [] (const TestSettings& settings) { return measureTierFadeCorrelation (settings, PlateReverbQuality::full, PlateReverbQuality::eco); },
+                   tierFadeCorrelation, true },
+                 { "Full to eco switch: tail level difference to eco below rate / 6 (dB)",
+                   [] (const TestSettings& settings) { return measureTierTailDeviation (settings, PlateReverbQuality::full, PlateReverbQuality::eco); },
+                   tierTailDeviationDecibels, false },
+                 { "Eco to full switch: correlation with the eco tier during the fade",
+                   [] (const TestSettings& settings) { return measureTierFadeCorrelation (settings, PlateReverbQuality::eco, PlateReverbQuality::full); },
+                   tierFadeCorrelation, true },
+                 { "Eco to full switch: tail level difference to full below rate / 6 (dB)",
+                   [] (const TestSettings& settings) { return measureTierTailDeviation (settings, PlateReverbQuality::eco, PlateReverbQuality::full); },
+                   tierTailDeviationDecibels, false },
+                 { "True stereo, L = R: max abs difference to the mono path",
+                   measureTrueStereoAgainstMono, trueStereoMaximumError, false },
+                 { "Waking from sleep: max abs difference to an engine that never slept",
+                   measureWakeFromSleep, wakeFromSleepMaximumError, false } };
+    }
+
+    //==============================================================================
+    void printUsage()
+    {
+        std::cout << "Usage: PlateReverbEquivalence [options]" << std::endl
+                  << std::endl
+                  << "Options:" << std::endl
+                  << "  --sample-rate=<Hz>          (default 48000)" << std::endl
+                  << "  --seconds=<s>               length of each render, half excitation and half tail (default 4)" << std::endl
+                  << "  --block-size=<n>            largest random host block size (default 512)" << std::endl
+                  << "  --seed=<n>                  seed for noise, automation and block sizes (default 1)" << std::endl
+                  << "  --engine=<text>             only test configurations whose name contains text" << std::endl
+                  << "  --max-abs-error=<value>     (default 1e-4)" << std::endl
+                  << "  --max-error-db=<dB>         peak error relative to the reference peak (default -80)" << std::endl
+                  << "  --max-spectral-db=<dB>      largest average spectrum difference (default 0.1)" << std::endl;
+    }
+
+    bool parseArguments (int argc, char* argv[], TestSettings& settings)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            String arg (argv[i]);
+
+            if (! arg.startsWith ("--"))
+                return false;
+
+            auto name = arg.substring (2).upToFirstOccurrenceOf ("=", false, false);
+            auto value = arg.fromFirstOccurrenceOf ("=", false, false);
+
+            if (value.isEmpty())
+            {
+                std::cerr << "Missing value for option --" << name << std::endl;
+                return false;
+            }
+
+            auto& tolerances = settings.tolerances;
+
+            if      (name == "sample-rate")     settings.sampleRate = jlimit (8000.0, 384000.0, value.getDoubleValue());
+            else if (name == "seconds")         settings.seconds = jmax (0.5, value.getDoubleValue());
+            else if (name == "block-size")      settings.maximumBlockSize = jmax (1, value.getIntValue());
+            else if (name == "seed")            settings.seed = value.getIntValue();
+            else if (name == "engine")          settings.engineFilter = value;
+            else if (name == "max-abs-error")   tolerances.maxAbsoluteError = value.getDoubleValue();
+            else if (name == "max-error-db")    tolerances.maxErrorDecibels = value.getDoubleValue();
+            else if (name == "max-spectral-db") tolerances.maxSpectralDeviationDecibels = value.getDoubleValue();
+            else
+            {
+                std::cerr << "Unknown option --" << name << std::endl;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    String formatDecibels (double decibels)
+    {
+        return decibels <= silenceDecibels ? String ("-inf") : String (decibels, 1);
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    TestSettings settings;
+
+    if (! parseArguments (argc, argv, settings))
+    {
+        printUsage();
+        return 1;
+    }
+
+    ScopedNoDenormals noDenormals;
+
+    auto numSamples = (int) (settings.seconds * settings.sampleRate);
+    auto automation = makeAutomation (settings.sampleRate, numSamples, settings.seed + 1);
+    auto blockSizes = makeBlockSizes (numSamples, settings.maximumBlockSize, settings.seed + 2);
+
+    int numComparisons = 0;
+    int numFailures = 0;
+
+    std::cout << "Equivalence against Reference/ at " << settings.sampleRate << " Hz, "
+              << settings.seconds << " s per render, blocks of 1 to " << settings.maximumBlockSize << std::endl
+              << "Tolerances: max abs error " << settings.tolerances.maxAbsoluteError
+              << ", error " << settings.tolerances.maxErrorDecibels << " dB"
+              << ", spectral deviation " << settings.tolerances.maxSpectralDeviationDecibels << " dB" << std::endl;
+
+    for (auto& engine : getEnginesUnderTest())
+    {
+        if (settings.engineFilter.isNotEmpty() && ! engine.name.contains (settings.engineFilter))
+            continue;
+
+        std::cout << std::endl << engine.name << std::endl;
+
+        for (auto signal : { Signal::impulse, Signal::noise, Signal::sweep })
+        {
+            for (auto automated : { false, true })
+            {
+                RenderJob job { settings.sampleRate,
+                                settings.maximumBlockSize,
+                                makeSignal (signal, settings.sampleRate, numSamples, settings.seed),
+                                blockSizes,
+                                automated ? automation : Array<AutomationEvent>() };
+
+                auto comparison = compare (engine.renderReference (job), engine.renderEngine (job));
+                auto passed = comparison.passes (settings.tolerances);
+
+                ++numComparisons;
+
+                if (! passed)
+                    ++numFailures;
+
+                auto caseName = String (getSignalName (signal)) + (automated ? ", automated" : "");
+
+                std::cout << "  " << caseName.paddedRight (' ', 20)
+                          << "max abs " << String (comparison.maxAbsoluteError, 9).paddedLeft (' ', 12)
+                          << "  error " << formatDecibels (comparison.errorDecibels).paddedLeft (' ', 7) << " dB"
+                          << "  spectrum " << String (comparison.spectralDeviationDecibels, 4).paddedLeft (' ', 8) << " dB"
+                          << (passed ? "  ok" : "  FAILED") << std::endl;
+            }
+        }
+    }
+
+    std::cout << std::endl << "Behaviour checks against the engine's default path" << std::endl;
+
+    for (auto& check : getBehaviourChecks())
+    {
+        if (settings.engineFilter.isNotEmpty() && ! check.name.contains (settings.engineFilter))
+            continue;
+
+        auto value = check.measure (settings);
+        auto passed = check.passes (value);
+
+        ++numComparisons;
+
+        if (! passed)
+            ++numFailures;
+
+        std::cout << "  " << check.name.paddedRight (' ', 72)
+                  << String (value, 9).paddedLeft (' ', 14)
+                  << (check.isMinimum ? "  >= " : "  <= ") << String (check.limit, 9)
+                  << (passed ? "  ok" : "  FAILED") << std::endl;
+    }
+
+    std::cout << std::endl << (numComparisons - numFailures) << " of " << numComparisons << " comparisons within tolerance" << std::endl;
+
+    return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,294 @@
+/*
+  ==============================================================================
+
+    BatchRender.cpp
+
+  ==============================================================================
+*/
+
+#include "BatchRender.h"
+#include <iostream>
+
+namespace BatchRender
+{
+    namespace
+    {
+        // samples each file keeps decoded ahead of the engine and encoded behind it
+        constexpr int ioBufferSamples = 1 << 16;
+
+        // decoding and encoding are much cheaper than the reverb, a few threads keep many workers fed
+        constexpr int workersPerIoThread = 4;
+
+        // of the basic formats, the ones with a writer. the others, like MP3, are rendered to WAV
+        const char* const writableExtensions = ".wav;.aiff;.aif;.flac;.ogg";
+
+        /*  One file through one preset on its own engine. Decoding runs ahead
+            on an I/O thread through a BufferingAudioReader and encoding
+            behind through a ThreadedWriter, so the worker only runs the
+            reverb unless the I/O thread falls behind.
+        */
+        class RenderJob  : public ThreadPoolJob
+        {
+        public:
+            RenderJob (const File& input, const File& output, const Preset& presetToUse,
+                       const Settings& settingsToUse, TimeSliceThread& ioThreadToUse)
+                : ThreadPoolJob (input.getFileName()),
+                  inputFile (input), outputFile (output), preset (presetToUse),
+                  settings (settingsToUse), ioThread (ioThreadToUse)
+            {
+            }
+
+            JobStatus runJob() override
+            {
+                succeeded = render();
+                return jobHasFinished;
+            }
+
+            bool succeeded = false;
+            double audioSeconds = 0.0;
+
+        private:
+            bool fail (const String& message)
+            {
+                std::cerr << message << std::endl;
+                return false;
+            }
+
+            bool render()
+            {
+                // AudioFormatManager isn't meant to be shared between threads, so every job registers its own
+                AudioFormatManager formatManager;
+                formatManager.registerBasicFormats();
+
+                std::unique_ptr<AudioFormatReader> sourceReader (formatManager.createReaderFor (inputFile));
+
+                if (sourceReader == nullptr)
+                    return fail ("Could not open " + inputFile.getFullPathName());
+
+                auto sampleRate = sourceReader->sampleRate;
+                auto inputLength = sourceReader->lengthInSamples;
+                auto sourceBitsPerSample = (int) sourceReader->bitsPerSample;
+
+                auto* outputFormat = formatManager.findFormatForFileExtension (outputFile.getFileExtension());
+
+                if (outputFormat == nullptr)
+                    return fail ("Unsupported output format " + outputFile.getFileExtension());
+
+                // checkOutputFiles() keeps this from happening, but it would cost the source
+                if (outputFile == inputFile)
+                    return fail ("Refusing to overwrite the input file " + inputFile.getFullPathName());
+
+                outputFile.deleteFile();
+                std::unique_ptr<OutputStream> outputStream (outputFile.createOutputStream());
+
+                if (outputStream == nullptr)
+                    return fail ("Could not write " + outputFile.getFullPathName());
+
+                // the engine always renders a stereo image, mono sources are duplicated by the reader
+                const int numChannels = 2;
+                auto bitsPerSample = outputFormat->getPossibleBitDepths().contains (sourceBitsPerSample) ? sourceBitsPerSample : 24;
+
+                std::unique_ptr<AudioFormatWriter> writer (outputFormat->createWriterFor (outputStream.get(), sampleRate,
+                                                                                          (unsigned int) numChannels,
+                                                                                          bitsPerSample, {}, 0));
+                if (writer == nullptr)
+                    return fail ("Could not create a writer for " + outputFile.getFullPathName());
+
+                // the writer owns the stream from here on, and the threaded writer the writer
+                outputStream.release();
+
+                auto bufferSamples = jmax (ioBufferSamples, 4 * settings.blockSize);
+
+                BufferingAudioReader reader (sourceReader.release(), ioThread, bufferSamples);
+                reader.setReadTimeout (-1);
+
+                AudioFormatWriter::ThreadedWriter threadedWriter (writer.release(), ioThread, bufferSamples);
+
+                PlateReverb<float> reverb;
+                reverb.setParameters (preset.parameters);
+                reverb.setTrueStereoEnabled (settings.trueStereo);
+                reverb.prepareToPlay (sampleRate, settings.blockSize);
+
+                AudioBuffer<float> buffer (numChannels, settings.blockSize);
+
+                auto tailSeconds = settings.automaticTail ? reverb.getTailLengthSeconds() : settings.tailSeconds;
+                auto totalLength = inputLength + (int64) (tailSeconds * sampleRate);
+
+                for (int64 position = 0; position < totalLength; position += settings.blockSize)
+                {
+                    auto numSamples = (int) jmin ((int64) settings.blockSize, totalLength - position);
+
+                    buffer.clear();
+
+                    if (position < inputLength)
+                        reader.read (&buffer, 0, (int) jmin ((int64) numSamples, inputLength - position), position, true, true);
+
+                    reverb.processBlock (buffer, numSamples, numChannels);
+
+                    // the encoder is behind, give it a moment instead of spinning
+                    while (! threadedWriter.write (buffer.getArrayOfReadPointers(), numSamples))
+                        Thread::sleep (1);
+                }
+
+                audioSeconds = (double) totalLength / sampleRate;
+                return true;
+            }
+
+            File inputFile;
+            File outputFile;
+            Preset preset;
+            const Settings& settings;
+            TimeSliceThread& ioThread;
+
+            JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderJob)
+        };
+
+        File getOutputFile (const Settings& settings, const File& input, const Preset& preset)
+        {
+            auto name = input.getFileNameWithoutExtension();
+
+            if (preset.name.isNotEmpty())
+                name << "_" << File::createLegalFileName (preset.name);
+
+            auto extension = input.hasFileExtension (writableExtensions) ? input.getFileExtension() : String (".wav");
+
+            return settings.outputFolder.getChildFile (name + extension);
+        }
+    }
+
+    Array<File> findAudioFiles (const File& folder)
+    {
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        auto files = folder.findChildFiles (File::findFiles, false, formatManager.getWildcardForAllFormats());
+        files.sort();
+
+        return files;
+    }
+
+    bool checkOutputFiles (const Settings& settings)
+    {
+        Array<File> outputFiles;
+
+        for (auto& input : settings.inputFiles)
+        {
+            for (auto& preset : settings.presets)
+            {
+                auto output = getOutputFile (settings, input, preset);
+
+                if (settings.inputFiles.contains (output))
+                {
+                    std::cerr << "Rendering " << input.getFullPathName() << " would overwrite "
+                              << output.getFullPathName() << ", choose another output folder or name the presets" << std::endl;
+                    return false;
+                }
+
+                if (outputFiles.contains (output))
+                {
+                    std::cerr << "More than one render would be written to " << output.getFullPathName() << std::endl;
+                    return false;
+                }
+
+                outputFiles.add (output);
+            }
+        }
+
+        return true;
+    }
+
+    Result run (const Settings& settings, int numThreads)
+    {
+        Result result;
+        result.numThreads = numThreads > 0 ? numThreads
+                          : settings.numThreads > 0 ? settings.numThreads
+                          : SystemStats::getNumCpus();
+
+        settings.outputFolder.createDirectory();
+
+        OwnedArray<TimeSliceThread> ioThreads;
+
+        for (int i = 0; i < jmax (1, result.numThreads / workersPerIoThread); ++i)
+            ioThreads.add (new TimeSliceThread ("Render I/O " + String (i + 1)))->startThread();
+
+        // the longest files go first, so no worker is left with a long one while the others idle at the end
+        auto inputFiles = settings.inputFiles;
+
+        std::stable_sort (inputFiles.begin(), inputFiles.end(),
+                          [] (const File& a, const File& b) { return a.getSize() > b.getSize(); });
+
+        OwnedArray<RenderJob> jobs;
+
+        for (auto& input : inputFiles)
+            for (auto& preset : settings.presets)
+                jobs.add (new RenderJob (input, getOutputFile (settings, input, preset), preset, settings,
+                                         *ioThreads[jobs.size() % ioThreads.size()]));
+
+        auto start = Time::getHighResolutionTicks();
+
+        {
+            // idle workers take the next job from the shared queue, which balances files of any length
+            ThreadPool pool (result.numThreads);
+
+            for (auto* job : jobs)
+                pool.addJob (job, false);
+
+            for (auto* job : jobs)
+                pool.waitForJobToFinish (job, -1);
+        }
+
+        result.wallSeconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start);
+        result.numJobs = jobs.size();
+
+        for (auto* job : jobs)
+        {
+            result.audioSeconds += job->audioSeconds;
+
+            if (! job->succeeded)
+                result.numFailedJobs++;
+        }
+
+        return result;
+    }
+
+    void measureScaling (const Settings& settings)
+    {
+        auto maximumThreads = settings.numThreads > 0 ? settings.numThreads : SystemStats::getNumCpus();
+
+        Array<int> threadCounts;
+
+        for (int numThreads = 1; numThreads < maximumThreads; numThreads *= 2)
+            threadCounts.add (numThreads);
+
+        threadCounts.add (maximumThreads);
+
+        std::cout << "Workers  Wall time  Realtime factor  Speedup  Efficiency" << std::endl;
+
+        double singleThreadFactor = 0.0;
+
+        for (auto numThreads : threadCounts)
+        {
+            auto result = run (settings, numThreads);
+            auto factor = result.getRealtimeFactor();
+
+            if (numThreads == 1)
+                singleThreadFactor = factor;
+
+            auto speedup = singleThreadFactor > 0.0 ? factor / singleThreadFactor : 0.0;
+
+            std::cout << String (numThreads).paddedLeft (' ', 7)
+                      << String (result.wallSeconds, 2).paddedLeft (' ', 10) << " s"
+                      << String (factor, 1).paddedLeft (' ', 16) << "x"
+                      << String (speedup, 2).paddedLeft (' ', 8) << "x"
+                      << String (100.0 * speedup / numThreads, 1).paddedLeft (' ', 11) << " %" << std::endl;
+        }
+    }
+
+    void printResult (const Result& result)
+    {
+        std::cout << "Rendered " << result.numJobs - result.numFailedJobs << " of " << result.numJobs << " jobs on "
+                  << result.numThreads << " workers: " << String (result.audioSeconds, 1) << " s of audio in "
+                  << String (result.wallSeconds, 2) << " s" << std::endl
+                  << "Realtime factor:  " << String (result.getRealtimeFactor(), 1) << "x" << std::endl;
+    }
+}
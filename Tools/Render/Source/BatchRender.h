@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    BatchRender.h
+    Renders every file of a folder with every preset of a list, one job
+    per file and preset on a pool of worker threads.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../../Source/Reverb/PlateReverb.h"
+
+namespace BatchRender
+{
+    struct Preset
+    {
+        // appended to the output file names, empty for a single unnamed preset
+        String name;
+        PlateReverbParameters parameters;
+    };
+
+    struct Settings
+    {
+        Array<File> inputFiles;
+        File outputFolder;
+        Array<Preset> presets;
+
+        int blockSize = 512;
+        double tailSeconds = 0.0;
+        bool automaticTail = false;
+        bool trueStereo = false;
+
+        // 0 runs one worker per CPU core
+        int numThreads = 0;
+    };
+
+    struct Result
+    {
+        int numThreads = 0;
+        int numJobs = 0;
+        int numFailedJobs = 0;
+        double audioSeconds = 0.0;
+        double wallSeconds = 0.0;
+
+        // seconds of audio rendered per second of wall clock time, over all jobs
+        double getRealtimeFactor() const { return wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0; }
+    };
+
+    // every audio file directly inside the folder that one of the basic formats can read
+    Array<File> findAudioFiles (const File& folder);
+
+    /*  False, with the reason printed, if an output file would replace one
+        of the input files or be written by more than one job. Inputs in a
+        format that can only be read are rendered to WAV.
+    */
+    bool checkOutputFiles (const Settings& settings);
+
+    // renders every file with every preset on numThreads workers, or on the count from the settings if 0
+    Result run (const Settings& settings, int numThreads = 0);
+
+    /*  Renders the whole batch on 1, 2, 4 .. up to all cores and prints how
+        throughput scales: the speedup over one worker and the efficiency,
+        the speedup divided by the number of workers.
+    */
+    void measureScaling (const Settings& settings);
+
+    void printResult (const Result& result);
+}
@@ -0,0 +1,407 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Headless offline renderer for the plate reverb.
+
+    Streams an audio file through the same PlateReverb engine the plugin
+    uses and reports how fast it ran. Given a folder, renders every file
+    in it with every preset of a list on all cores (see BatchRender.h).
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../../Source/Reverb/PlateReverb.h"
+#include "BatchRender.h"
+
+//==============================================================================
+namespace
+{
+    struct RenderSettings
+    {
+        File inputFile;
+        File outputFile;
+
+        int blockSize = 512;
+        double tailSeconds = 0.0;
+        bool automaticTail = false;
+        bool trueStereo = false;
+
+        // where to write the stage trace, builds with DATTORRO_PROFILE_STAGES only
+        File traceFile;
+
+        // batch mode, when the input is a folder
+        File presetsFile;
+        int numThreads = 0;
+        bool measureScaling = false;
+
+        // same defaults as the plugin's parameter layout
+        PlateReverbParameters parameters;
+    };
+
+    struct RenderStats
+    {
+        int64 numSamples = 0;
+        int numBlocks = 0;
+        int numSleepingBlocks = 0;
+        double sampleRate = 0.0;
+        double processingSeconds = 0.0;
+        double peakBlockSeconds = 0.0;
+        double estimatedTailSeconds = 0.0;
+        size_t footprintBytes = 0;
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: PlateReverbRender <input.wav|aiff> <output.wav|aiff> [options]" << std::endl
+                  << "       PlateReverbRender <input folder> <output folder> [options]" << std::endl
+                  << std::endl
+                  << "Options:" << std::endl
+                  << "  --predelay=<ms>        0 .. 1000      (default 0)" << std::endl
+                  << "  --decay=<value>        0 .. 1         (default 0.5)" << std::endl
+                  << "  --decayDif1=<value>    0 .. 1         (default 0.7)" << std::endl
+                  << "  --inputDif1=<value>    0 .. 1         (default 0.75)" << std::endl
+                  << "  --inputDif2=<value>    0 .. 1         (default 0.625)" << std::endl
+                  << "  --bandwidth=<value>    0 .. 1         (default 0.9995)" << std::endl
+                  << "  --damping=<value>      0 .. 1         (default 0.0005)" << std::endl
+                  << "  --mix=<value>          0 .. 1         (default 0.5)" << std::endl
+                  << "  --modRate=<Hz>         0.1 .. 5       (default 1)" << std::endl
+                  << "  --modDepth=<value>     0 .. 1         (default 0)" << std::endl
+                  << "  --block-size=<n>       host block size to simulate (default 512)" << std::endl
+                  << "  --tail=<seconds|auto>  silence appended to let the tail ring out, auto uses the" << std::endl
+                  << "                         engine's tail length estimate (default 0)" << std::endl
+                  << "  --true-stereo          separate input chains for left and right instead of" << std::endl
+                  << "                         summing them to mono" << std::endl
+                  << std::endl
+                  << "Folders:" << std::endl
+                  << "  --presets=<file>       one preset per line, a name followed by parameter options," << std::endl
+                  << "                         e.g. \"hall --decay=0.8 --mix=0.4\". every file is rendered" << std::endl
+                  << "                         with every preset (default: the options above, unnamed)" << std::endl
+                  << "  --threads=<n>          workers (default: one per CPU core)" << std::endl
+                  << "  --scaling              render the batch on 1, 2, 4 .. all workers and report how" << std::endl
+                  << "                         throughput scales" << std::endl;
+
+       #if DATTORRO_PROFILE_STAGES
+        std::cout << "  --profile=<trace.json> also write the stage timings as a Chrome trace" << std::endl;
+       #endif
+    }
+
+    // sets the parameter with this plugin parameter ID, false if there is none
+    bool setParameter (PlateReverbParameters& parameters, const String& name, const String& value)
+    {
+        if      (name == "predelay")   parameters.predelayTime = value.getFloatValue();
+        else if (name == "decay")      parameters.decay = value.getFloatValue();
+        else if (name == "decayDif1")  parameters.decayDiffusion1 = value.getFloatValue();
+        else if (name == "inputDif1")  parameters.inputDiffusion1 = value.getFloatValue();
+        else if (name == "inputDif2")  parameters.inputDiffusion2 = value.getFloatValue();
+        else if (name == "bandwidth")  parameters.bandwidth = value.getFloatValue();
+        else if (name == "damping")    parameters.damping = value.getFloatValue();
+        else if (name == "mix")        parameters.mix = value.getFloatValue();
+        else if (name == "modRate")    parameters.modulationRate = value.getFloatValue();
+        else if (name == "modDepth")   parameters.modulationDepth = value.getFloatValue();
+        else                           return false;
+
+        return true;
+    }
+
+    // every preset starts from the command line's parameters, so a list only has to name what it changes
+    bool readPresets (const RenderSettings& settings, Array<BatchRender::Preset>& presets)
+    {
+        if (settings.presetsFile == File())
+        {
+            presets.add (BatchRender::Preset { {}, settings.parameters });
+            return true;
+        }
+
+        StringArray lines;
+        settings.presetsFile.readLines (lines);
+
+        for (auto& line : lines)
+        {
+            auto tokens = StringArray::fromTokens (line.trim(), true);
+
+            if (tokens.isEmpty() || tokens[0].startsWith ("#"))
+                continue;
+
+            BatchRender::Preset preset { tokens[0], settings.parameters };
+
+            for (int i = 1; i < tokens.size(); ++i)
+            {
+                auto name = tokens[i].fromFirstOccurrenceOf ("--", false, false).upToFirstOccurrenceOf ("=", false, false);
+                auto value = tokens[i].fromFirstOccurrenceOf ("=", false, false);
+
+                if (value.isEmpty() || ! setParameter (preset.parameters, name, value))
+                {
+                    std::cerr << "Bad parameter " << tokens[i] << " in preset " << preset.name << std::endl;
+                    return false;
+                }
+            }
+
+            presets.add (preset);
+        }
+
+        if (presets.isEmpty())
+        {
+            std::cerr << "No presets in " << settings.presetsFile.getFullPathName() << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool renderBatch (const RenderSettings& settings)
+    {
+        BatchRender::Settings batch;
+        batch.inputFiles = BatchRender::findAudioFiles (settings.inputFile);
+        batch.outputFolder = settings.outputFile;
+        batch.blockSize = settings.blockSize;
+        batch.tailSeconds = settings.tailSeconds;
+        batch.automaticTail = settings.automaticTail;
+        batch.numThreads = settings.numThreads;
+        batch.trueStereo = settings.trueStereo;
+
+        if (! readPresets (settings, batch.presets))
+            return false;
+
+        if (batch.inputFiles.isEmpty())
+        {
+            std::cerr << "No audio files in " << settings.inputFile.getFullPathName() << std::endl;
+            return false;
+        }
+
+        if (! BatchRender::checkOutputFiles (batch))
+            return false;
+
+        if (settings.measureScaling)
+        {
+            BatchRender::measureScaling (batch);
+            return true;
+        }
+
+        auto result = BatchRender::run (batch);
+        BatchRender::printResult (result);
+
+        return result.numFailedJobs == 0;
+    }
+
+    bool parseArguments (int argc, char* argv[], RenderSettings& settings)
+    {
+        StringArray positional;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            String arg (argv[i]);
+
+            if (! arg.startsWith ("--"))
+            {
+                positional.add (arg);
+                continue;
+            }
+
+            auto name = arg.substring (2).upToFirstOccurrenceOf ("=", false, false);
+            auto value = arg.fromFirstOccurrenceOf ("=", false, false);
+
+            if (name == "scaling")
+            {
+                settings.measureScaling = true;
+                continue;
+            }
+
+            if (name == "true-stereo")
+            {
+                settings.trueStereo = true;
+                continue;
+            }
+
+            if (value.isEmpty())
+            {
+                std::cerr << "Missing value for option --" << name << std::endl;
+                return false;
+            }
+
+            if (setParameter (settings.parameters, name, value))
+                continue;
+
+            if      (name == "block-size") settings.blockSize = jmax (1, value.getIntValue());
+            else if (name == "tail" && value == "auto") settings.automaticTail = true;
+            else if (name == "tail")       settings.tailSeconds = jmax (0.0, value.getDoubleValue());
+            else if (name == "presets")    settings.presetsFile = File::getCurrentWorkingDirectory().getChildFile (value);
+            else if (name == "threads")    settings.numThreads = jmax (1, value.getIntValue());
+           #if DATTORRO_PROFILE_STAGES
+            else if (name == "profile")    settings.traceFile = File::getCurrentWorkingDirectory().getChildFile (value);
+           #endif
+            else
+            {
+                std::cerr << "Unknown option --" << name << std::endl;
+                return false;
+            }
+        }
+
+        if (positional.size() != 2)
+            return false;
+
+        settings.inputFile = File::getCurrentWorkingDirectory().getChildFile (positional[0]);
+        settings.outputFile = File::getCurrentWorkingDirectory().getChildFile (positional[1]);
+        return true;
+    }
+
+    bool render (const RenderSettings& settings, RenderStats& stats)
+    {
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<AudioFormatReader> reader (formatManager.createReaderFor (settings.inputFile));
+
+        if (reader == nullptr)
+        {
+            std::cerr << "Could not open " << settings.inputFile.getFullPathName() << std::endl;
+            return false;
+        }
+
+        auto* outputFormat = formatManager.findFormatForFileExtension (settings.outputFile.getFileExtension());
+
+        if (outputFormat == nullptr)
+        {
+            std::cerr << "Unsupported output format " << settings.outputFile.getFileExtension() << std::endl;
+            return false;
+        }
+
+        settings.outputFile.deleteFile();
+        std::unique_ptr<OutputStream> outputStream (settings.outputFile.createOutputStream());
+
+        if (outputStream == nullptr)
+        {
+            std::cerr << "Could not write " << settings.outputFile.getFullPathName() << std::endl;
+            return false;
+        }
+
+        // the engine always renders a stereo image, mono sources are duplicated by the reader
+        const int numChannels = 2;
+        auto bitsPerSample = outputFormat->getPossibleBitDepths().contains ((int) reader->bitsPerSample)
+                           ? (int) reader->bitsPerSample : 24;
+
+        std::unique_ptr<AudioFormatWriter> writer (outputFormat->createWriterFor (outputStream.get(),
+                                                                                  reader->sampleRate,
+                                                                                  (unsigned int) numChannels,
+                                                                                  bitsPerSample,
+                                                                                  {}, 0));
+        if (writer == nullptr)
+        {
+            std::cerr << "Could not create a writer for " << settings.outputFile.getFullPathName() << std::endl;
+            return false;
+        }
+
+        // the writer owns the stream from here on
+        outputStream.release();
+
+        PlateReverb<float> reverb;
+        reverb.setParameters (settings.parameters);
+        reverb.setTrueStereoEnabled (settings.trueStereo);
+        reverb.prepareToPlay (reader->sampleRate, settings.blockSize);
+
+        AudioBuffer<float> buffer (numChannels, settings.blockSize);
+
+        stats.estimatedTailSeconds = reverb.getTailLengthSeconds();
+        stats.footprintBytes = reverb.getFootprintInBytes();
+
+        auto tailSeconds = settings.automaticTail ? stats.estimatedTailSeconds : settings.tailSeconds;
+        auto inputLength = reader->lengthInSamples;
+        auto totalLength = inputLength + (int64) (tailSeconds * reader->sampleRate);
+        auto ticksPerSecond = (double) Time::getHighResolutionTicksPerSecond();
+
+        stats.sampleRate = reader->sampleRate;
+
+        for (int64 position = 0; position < totalLength; position += settings.blockSize)
+        {
+            auto numSamples = (int) jmin ((int64) settings.blockSize, totalLength - position);
+
+            buffer.clear();
+
+            if (position < inputLength)
+                reader->read (&buffer, 0, (int) jmin ((int64) numSamples, inputLength - position), position, true, true);
+
+            auto start = Time::getHighResolutionTicks();
+            reverb.processBlock (buffer, numSamples, numChannels);
+            auto blockSeconds = (double) (Time::getHighResolutionTicks() - start) / ticksPerSecond;
+
+            stats.processingSeconds += blockSeconds;
+            stats.peakBlockSeconds = jmax (stats.peakBlockSeconds, blockSeconds);
+            stats.numSamples += numSamples;
+            stats.numBlocks++;
+
+            if (reverb.isSleeping())
+                stats.numSleepingBlocks++;
+
+            if (! writer->writeFromAudioSampleBuffer (buffer, 0, numSamples))
+            {
+                std::cerr << "Write failed at sample " << position << std::endl;
+                return false;
+            }
+        }
+
+       #if DATTORRO_PROFILE_STAGES
+        std::cout << "Stage profile:" << std::endl << reverb.getProfiler().getSummary() << std::endl;
+
+        if (settings.traceFile != File())
+        {
+            settings.traceFile.deleteFile();
+            FileOutputStream traceStream (settings.traceFile);
+
+            if (! traceStream.openedOk())
+            {
+                std::cerr << "Could not write " << settings.traceFile.getFullPathName() << std::endl;
+                return false;
+            }
+
+            reverb.getProfiler().writeChromeTrace (traceStream);
+        }
+       #endif
+
+        return true;
+    }
+
+    void printStats (const RenderSettings& settings, const RenderStats& stats)
+    {
+        if (stats.numSamples == 0 || stats.processingSeconds <= 0.0)
+            return;
+
+        auto audioSeconds = (double) stats.numSamples / stats.sampleRate;
+        auto blockBudgetSeconds = settings.blockSize / stats.sampleRate;
+
+        std::cout << "Rendered " << String (audioSeconds, 2) << " s of audio ("
+                  << stats.numSamples << " samples, " << stats.numBlocks << " blocks of "
+                  << settings.blockSize << " at " << stats.sampleRate << " Hz)" << std::endl
+                  << "Realtime factor:  " << String (audioSeconds / stats.processingSeconds, 1) << "x" << std::endl
+                  << "ns/sample:        " << String (stats.processingSeconds * 1.0e9 / (double) stats.numSamples, 2) << std::endl
+                  << "Peak block time:  " << String (stats.peakBlockSeconds * 1.0e6, 1) << " us ("
+                  << String (100.0 * stats.peakBlockSeconds / blockBudgetSeconds, 1) << "% of block budget)" << std::endl
+                  << "Engine footprint: " << String ((double) stats.footprintBytes / 1024.0, 1) << " KiB" << std::endl
+                  << "Estimated tail:   " << String (stats.estimatedTailSeconds, 2) << " s" << std::endl
+                  << "Tank asleep:      " << String (100.0 * stats.numSleepingBlocks / stats.numBlocks, 1) << "% of blocks" << std::endl;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    RenderSettings settings;
+
+    if (! parseArguments (argc, argv, settings))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (settings.inputFile.isDirectory())
+        return renderBatch (settings) ? 0 : 1;
+
+    RenderStats stats;
+
+    if (! render (settings, stats))
+        return 1;
+
+    printStats (settings, stats);
+    return 0;
+}